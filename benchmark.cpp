@@ -0,0 +1,234 @@
+/**
+ * benchmark.cpp
+ * Throughput benchmarks for the input parsing path.
+ * Run from the directory holding the generated input files (where main was run);
+ * any that are missing are generated first with the same bonds as main.
+ *
+ */
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "datagenerator.hpp"
+#include "products.hpp"
+#include "mappedfile.hpp"
+#include "marketdatabinary.hpp"
+#include "tokenizer.hpp"
+#include "treasuryprices.hpp"
+#include "util.hpp"
+
+using namespace std;
+
+//Seconds elapsed since start
+double elapsed(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+bool file_exists(const char* path) {
+	ifstream input_file(path);
+	return input_file.good();
+}
+
+//Generate marketdata.txt for the seven on the run treasuries if it isn't there yet
+void ensure_market_data(int n_updates) {
+
+	if (file_exists("marketdata.txt")) {
+		return;
+	}
+
+	vector<TreasuryPrices> halfspreads;
+	halfspreads.push_back(TreasuryPrices(0, 0, 1));
+	halfspreads.push_back(TreasuryPrices(0, 0, 2));
+	halfspreads.push_back(TreasuryPrices(0, 0, 3));
+	halfspreads.push_back(TreasuryPrices(0, 0, 4));
+
+	vector<Bond> bonds;
+	bonds.push_back(Bond("91282CFX4", CUSIP, "T", 4.5, "20241130"));
+	bonds.push_back(Bond("91282CGA3", CUSIP, "T", 4.0, "20251215"));
+	bonds.push_back(Bond("91282CFZ9", CUSIP, "T", 3.875, "20271130"));
+	bonds.push_back(Bond("91282CFY2", CUSIP, "T", 3.875, "20291130"));
+	bonds.push_back(Bond("91282CFV8", CUSIP, "T", 4.125, "20321130"));
+	bonds.push_back(Bond("912810TM0", CUSIP, "T", 4.0, "20421115"));
+	bonds.push_back(Bond("912810TL2", CUSIP, "T", 4.0, "20521115"));
+
+	cout << "Generating marketdata.txt" << endl;
+
+	BondGenerator g(bonds, halfspreads);
+	g.generateMarketData(n_updates, 5);
+}
+
+//util.hpp split against the block-scanning Tokenizer, over every line of marketdata.txt
+void benchmark_tokenizer() {
+
+	size_t lines = 0, fields = 0;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	{
+		ifstream input_file("marketdata.txt");
+		string update;
+
+		while (getline(input_file, update)) {
+			vector<string> update_split = split(update, ",");
+			fields += update_split.size();
+			lines++;
+		}
+	}
+	double split_seconds = elapsed(start);
+
+	size_t bytes = 0, tokenizer_fields = 0;
+
+	start = chrono::steady_clock::now();
+	{
+		MappedFile input_file("marketdata.txt");
+		Tokenizer tokenizer(input_file);
+		vector<StringView> update_split;
+
+		bytes = input_file.size();
+
+		while (tokenizer.NextLine(update_split)) {
+			tokenizer_fields += update_split.size();
+		}
+	}
+	double tokenizer_seconds = elapsed(start);
+
+	if (fields != tokenizer_fields) {
+		cout << "Field count mismatch: split " << fields << ", tokenizer " << tokenizer_fields << endl;
+	}
+
+	cout << "marketdata.txt: " << lines << " lines, " << fields << " fields, " << bytes / 1e6 << " MB" << endl;
+	cout << "  getline + split:     " << split_seconds * 1e9 / lines << " ns/line, " << bytes / 1e6 / split_seconds << " MB/s" << endl;
+	cout << "  mmap + Tokenizer:    " << tokenizer_seconds * 1e9 / lines << " ns/line, " << bytes / 1e6 / tokenizer_seconds << " MB/s" << endl;
+	cout << "  speedup:             " << split_seconds / tokenizer_seconds << "x" << endl;
+}
+
+//The TreasuryPrices string parse this repo used to do: three substrings and three sscanf calls
+int legacy_parse_ticks(const string& s) {
+
+	int integer = 0, xy = 0, z = 4;
+
+	string::size_type delim_position = s.find("-");
+
+	sscanf(s.substr(0, delim_position).c_str(), "%d", &integer);
+	sscanf(s.substr(delim_position + 1, 2).c_str(), "%d", &xy);
+	sscanf(s.substr(delim_position + 3, 1).c_str(), "%d", &z);
+
+	return integer * TICKS_PER_POINT + xy * 8 + z;
+}
+
+//Per-price cost of the legacy parse against parse_ticks and parse_ticks_batch, over every
+//order price in marketdata.txt
+void benchmark_price_parser() {
+
+	MappedFile input_file("marketdata.txt");
+	Tokenizer tokenizer(input_file);
+	vector<StringView> update_split;
+
+	vector<StringView> price_fields;
+	vector<string> price_strings;
+
+	while (tokenizer.NextLine(update_split)) {
+		for (size_t i = 3; i < update_split.size(); i += 3) {
+			price_fields.push_back(update_split[i]);
+			price_strings.push_back(update_split[i].str());
+		}
+	}
+
+	size_t n = price_fields.size();
+	vector<int> ticks(n);
+	long long legacy_sum = 0, single_sum = 0, batch_sum = 0;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (size_t i = 0; i < n; i++) {
+		legacy_sum += legacy_parse_ticks(price_strings[i]);
+	}
+	double legacy_seconds = elapsed(start);
+
+	start = chrono::steady_clock::now();
+	for (size_t i = 0; i < n; i++) {
+		single_sum += parse_ticks(price_fields[i]);
+	}
+	double single_seconds = elapsed(start);
+
+	start = chrono::steady_clock::now();
+	parse_ticks_batch(&price_fields[0], n, 1, &ticks[0]);
+	for (size_t i = 0; i < n; i++) {
+		batch_sum += ticks[i];
+	}
+	double batch_seconds = elapsed(start);
+
+	if (legacy_sum != single_sum || single_sum != batch_sum) {
+		cout << "Tick sum mismatch: " << legacy_sum << " " << single_sum << " " << batch_sum << endl;
+	}
+
+	cout << "marketdata.txt: " << n << " prices" << endl;
+	cout << "  substr + sscanf:     " << legacy_seconds * 1e9 / n << " ns/price" << endl;
+	cout << "  parse_ticks:         " << single_seconds * 1e9 / n << " ns/price" << endl;
+	cout << "  parse_ticks_batch:   " << batch_seconds * 1e9 / n << " ns/price" << endl;
+}
+
+//Loading every level of marketdata.txt from the text against the converted binary records
+void benchmark_binary_market_data() {
+
+	size_t books = convert_market_data("marketdata.txt", "marketdata.bin");
+
+	long long text_sum = 0, binary_sum = 0;
+	size_t text_bytes = 0, binary_bytes = 0;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	{
+		MappedFile input_file("marketdata.txt");
+		Tokenizer tokenizer(input_file);
+		vector<StringView> update_split;
+
+		text_bytes = input_file.size();
+
+		while (tokenizer.NextLine(update_split)) {
+			for (size_t i = 3; i + 1 < update_split.size(); i += 3) {
+				text_sum += parse_ticks(update_split[i]) + parse_long(update_split[i + 1]);
+			}
+		}
+	}
+	double text_seconds = elapsed(start);
+
+	start = chrono::steady_clock::now();
+	{
+		BinaryBookReader input_file("marketdata.bin");
+
+		binary_bytes = input_file.Count() * sizeof(BinaryBook);
+
+		for (size_t r = 0; r < input_file.Count(); r++) {
+
+			const BinaryBook& book = input_file.Record(r);
+
+			for (int k = 0; k < book.bid_levels; k++) {
+				binary_sum += book.bid_ticks[k] + book.bid_quantities[k];
+			}
+			for (int k = 0; k < book.offer_levels; k++) {
+				binary_sum += book.offer_ticks[k] + book.offer_quantities[k];
+			}
+		}
+	}
+	double binary_seconds = elapsed(start);
+
+	if (text_sum != binary_sum) {
+		cout << "Level sum mismatch: text " << text_sum << ", binary " << binary_sum << endl;
+	}
+
+	cout << "marketdata.bin: " << books << " books" << endl;
+	cout << "  text levels:         " << text_seconds * 1e9 / books << " ns/book, " << text_bytes / 1e6 / text_seconds << " MB/s" << endl;
+	cout << "  binary levels:       " << binary_seconds * 1e9 / books << " ns/book, " << binary_bytes / 1e6 / binary_seconds << " MB/s" << endl;
+	cout << "  speedup:             " << text_seconds / binary_seconds << "x" << endl;
+}
+
+int main() {
+
+	ensure_market_data(100000);
+
+	benchmark_tokenizer();
+
+	benchmark_price_parser();
+
+	benchmark_binary_market_data();
+}
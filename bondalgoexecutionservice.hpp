@@ -6,6 +6,8 @@
 
 #include "executionservice.hpp"
 #include "bondmarketdataservice.hpp"
+#include "consolidatedbook.hpp"
+#include "keyedstore.hpp"
 
 template<typename T>
 class AlgoExecution {
@@ -41,16 +43,21 @@ Market AlgoExecution<T>::GetMarket() {
 }
 
 //Not an ExecutionService since we would need to set : public ExecutionService<AlgoExecution<Bond> > but AlgoExecution is not an ExecutionOrder
-class BondAlgoExecutionService
+template<typename L = DynamicListeners<AlgoExecution<Bond> > >
+class BasicBondAlgoExecutionService
 {
 private:
 	
-	vector<string> product_vec;
-	vector<AlgoExecution<Bond> > algo_exe_vec;
-	vector<ServiceListener<AlgoExecution<Bond> >* > listeners;
+	ProductStore<AlgoExecution<Bond> > algo_exe_store;
+	L listeners;
 
 public:;
 
+	BasicBondAlgoExecutionService();
+
+	// ctor wiring the listeners up front, needed for a StaticListeners set
+	BasicBondAlgoExecutionService(const L& listeners_);
+
 	// Get data on our service given a key
 	  AlgoExecution<Bond> GetData(string);
 
@@ -69,16 +76,27 @@ public:;
 
 };
 
-class BondMarketDataServiceListener : public ServiceListener<OrderBook<Bond> >
+typedef BasicBondAlgoExecutionService<> BondAlgoExecutionService;
+
+template<typename S = BondAlgoExecutionService>
+class BasicBondMarketDataServiceListener : public ServiceListener<OrderBook<Bond> >
 {
 private:
-	BondAlgoExecutionService* algoexe_service;
+	S* algoexe_service;
 	PricingSide side;
 	Market mkt;
 
+	//Consolidated books to route by, NULL to rotate through the venues
+	const ProductStore<ConsolidatedBook<Bond> >* consolidated_books;
+
 public:
 
-	BondMarketDataServiceListener(BondAlgoExecutionService*);
+	BasicBondMarketDataServiceListener(S*);
+
+	// Route each order to the venue showing the most at the best consolidated price, for
+	// products with a consolidated book. Books must be read as they are published, so the
+	// listener can't be decoupled onto another thread.
+	void RouteByVenue(const ProductStore<ConsolidatedBook<Bond> >* books);
 
 	// Listener callback to process an add event to the Service
 	void ProcessAdd(OrderBook<Bond>& data);
@@ -91,95 +109,100 @@ public:
 
 };
 
+typedef BasicBondMarketDataServiceListener<> BondMarketDataServiceListener;
+
+template<typename L>
+BasicBondAlgoExecutionService<L>::BasicBondAlgoExecutionService() {}
+
+template<typename L>
+BasicBondAlgoExecutionService<L>::BasicBondAlgoExecutionService(const L& listeners_) :
+	listeners(listeners_)
+{
+}
+
 // Get data on our service given a key
-AlgoExecution<Bond> BondAlgoExecutionService::GetData(string product_id) {
-	int index = find(product_vec.begin(), product_vec.end(), product_id) - product_vec.begin();
-	return algo_exe_vec[index];
+template<typename L>
+AlgoExecution<Bond> BasicBondAlgoExecutionService<L>::GetData(string product_id) {
+	return *algo_exe_store.Find(product_id);
 }
 
 // The callback that a Connector should invoke for any new or updated data
-void BondAlgoExecutionService::OnMessage(AlgoExecution<Bond>& exe) {
+template<typename L>
+void BasicBondAlgoExecutionService<L>::OnMessage(AlgoExecution<Bond>& exe) {
 	
-	int index = find(product_vec.begin(), product_vec.end(), exe.GetExecutionOrder().GetProduct().GetProductId()) - product_vec.begin();
+	const ExecutionOrder<Bond> order = exe.GetExecutionOrder();
+	algo_exe_store.Put(order.GetProductIndex(), order.GetProduct().GetProductId(), exe);
 
-	if (index < product_vec.size()) {
-		product_vec.erase(product_vec.begin() + index);
-		algo_exe_vec.erase(algo_exe_vec.begin() + index);
-	}
-
-	product_vec.push_back(exe.GetExecutionOrder().GetProduct().GetProductId());
-	algo_exe_vec.push_back(exe);
-
-	for (int i = 0; i < listeners.size(); i++) {
-		listeners[i]->ProcessAdd(exe);
-	}
+	listeners.ProcessAdd(exe);
 
 }
 
 // Execute an order on a market
-void BondAlgoExecutionService::ExecuteOrder(const ExecutionOrder<Bond>& order, Market market) {
+template<typename L>
+void BasicBondAlgoExecutionService<L>::ExecuteOrder(const ExecutionOrder<Bond>& order, Market market) {
 	AlgoExecution<Bond> algo_exe(order, market);
 	OnMessage(algo_exe);
 }
 
 // Add a listener to the Service for callbacks on add, remove, and update events
 // for data to the Service.
-void BondAlgoExecutionService::AddListener(ServiceListener<AlgoExecution<Bond> >* listener) {
-	listeners.push_back(listener);
+template<typename L>
+void BasicBondAlgoExecutionService<L>::AddListener(ServiceListener<AlgoExecution<Bond> >* listener) {
+	listeners.Add(listener);
 }
 
 // Get all listeners on the Service.
-const vector<ServiceListener<AlgoExecution<Bond> >*>& BondAlgoExecutionService::GetListeners() const {
-	return listeners;
+template<typename L>
+const vector<ServiceListener<AlgoExecution<Bond> >*>& BasicBondAlgoExecutionService<L>::GetListeners() const {
+	return listeners.Get();
 }
 
-BondMarketDataServiceListener::BondMarketDataServiceListener(BondAlgoExecutionService* algoexe_service_) {
+template<typename S>
+BasicBondMarketDataServiceListener<S>::BasicBondMarketDataServiceListener(S* algoexe_service_) {
 	side = BID;
 	algoexe_service = algoexe_service_;
 	mkt = BROKERTEC;
+	consolidated_books = NULL;
 }
 
-// Listener callback to process an add event to the Service
-void BondMarketDataServiceListener::ProcessAdd(OrderBook<Bond>& data) {
-
-	vector<Order> bid_stack = data.GetBidStack();
-	vector<Order> offer_stack = data.GetOfferStack();
-
-	Order best_bid = bid_stack.front();
-	Order best_offer = offer_stack.front();
-
-	for (int i = 1; i < bid_stack.size(); i++) {
+template<typename S>
+void BasicBondMarketDataServiceListener<S>::RouteByVenue(const ProductStore<ConsolidatedBook<Bond> >* books) {
+	consolidated_books = books;
+}
 
-		if (best_bid.GetPrice() < bid_stack[i].GetPrice()) {
-			best_bid = bid_stack[i];
-		}
+// Listener callback to process an add event to the Service
+template<typename S>
+void BasicBondMarketDataServiceListener<S>::ProcessAdd(OrderBook<Bond>& data) {
 
+	//A one sided book has nothing to cross
+	if (data.GetBidStack().empty() || data.GetOfferStack().empty()) {
+		return;
 	}
 
-	for (int i = 1; i < offer_stack.size(); i++) {
-
-		if (best_offer.GetPrice() > offer_stack[i].GetPrice()) {
-			best_offer = offer_stack[i];
-		}
+	const Order& best_bid = data.GetBestBidOffer().GetBidOrder();
+	const Order& best_offer = data.GetBestBidOffer().GetOfferOrder();
 
+	//A crossed book, as venues' books merged together can be, is not a tight spread to trade on
+	if (best_offer.GetPrice() < best_bid.GetPrice()) {
+		return;
 	}
 
-	if (abs(best_offer.GetPrice() - best_bid.GetPrice() < (1.0 / 128) + 1e-9)) {
+	//Execute when the spread is at its tightest, 1/128 or two ticks
+	if (best_offer.GetPrice() - best_bid.GetPrice() <= TickPrice::fromTicks(2)) {
 
-		if (side == BID) {
+		//Buying lifts the best offer, selling hits the best bid
+		const Order& best = side == BID ? best_offer : best_bid;
+		Market market = mkt;
+		long quantity = best.GetQuantity();
 
-			//No access to std::to_string - setting constant OrderID
-			ExecutionOrder<Bond> exec(data.GetProduct(), side, "OrderID", MARKET, best_offer.GetPrice(), best_offer.GetQuantity(), 0, "", false);
-			algoexe_service->ExecuteOrder(exec, mkt);
-			side = OFFER;
-		}
-		else {
-			ExecutionOrder<Bond> exec(data.GetProduct(), side, "OrderID", MARKET, best_bid.GetPrice(), best_bid.GetQuantity(), 0, "", false);
-			algoexe_service->ExecuteOrder(exec, mkt);
-			side = BID;
-		}
+		const ConsolidatedBook<Bond>* consolidated = consolidated_books == NULL ? NULL : consolidated_books->Find(data.GetProductIndex());
 
-		if (mkt == BROKERTEC) {
+		if (consolidated != NULL) {
+			const ConsolidatedLevel& level = consolidated->GetLevel(side == BID ? OFFER : BID, 0);
+			market = level.BestVenue();
+			quantity = level.venue_quantities[market];
+		}
+		else if (mkt == BROKERTEC) {
 			mkt = ESPEED;
 		}
 		else if (mkt == ESPEED) {
@@ -188,13 +211,20 @@ void BondMarketDataServiceListener::ProcessAdd(OrderBook<Bond>& data) {
 		else {
 			mkt = BROKERTEC;
 		}
+
+		//No access to std::to_string - setting constant OrderID
+		ExecutionOrder<Bond> exec(data.GetProduct(), side, "OrderID", MARKET, best.GetPrice(), quantity, 0, "", false);
+		algoexe_service->ExecuteOrder(exec, market);
+		side = side == BID ? OFFER : BID;
 	}
 }
 
 // Listener callback to process a remove event to the Service
-void BondMarketDataServiceListener::ProcessRemove(OrderBook<Bond>& data) {}
+template<typename S>
+void BasicBondMarketDataServiceListener<S>::ProcessRemove(OrderBook<Bond>& data) {}
 
 // Listener callback to process an update event to the Service
-void BondMarketDataServiceListener::ProcessUpdate(OrderBook<Bond>& data) {}
+template<typename S>
+void BasicBondMarketDataServiceListener<S>::ProcessUpdate(OrderBook<Bond>& data) {}
 
 #endif
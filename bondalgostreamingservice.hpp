@@ -6,6 +6,7 @@
 
 #include "streamingservice.hpp"
 #include "bondpricingservice.hpp"
+#include "keyedstore.hpp"
 
 template<typename T>
 class AlgoStream {
@@ -36,8 +37,7 @@ class BondAlgoStreamingService
 {
 private:
 	
-	vector<string> product_vec;
-	vector<AlgoStream<Bond> > algo_stream_vec;
+	ProductStore<AlgoStream<Bond> > algo_stream_store;
 	vector<ServiceListener<AlgoStream<Bond> >* > listeners;
 
 public:;
@@ -83,22 +83,14 @@ public:
 
 // Get data on our service given a key
 AlgoStream<Bond> BondAlgoStreamingService::GetData(string product_id) {
-	int index = find(product_vec.begin(), product_vec.end(), product_id) - product_vec.begin();
-	return algo_stream_vec[index];
+	return *algo_stream_store.Find(product_id);
 }
 
 // The callback that a Connector should invoke for any new or updated data
 void BondAlgoStreamingService::OnMessage(AlgoStream<Bond>& stream) {
 	
-	int index = find(product_vec.begin(), product_vec.end(), stream.GetPriceStream().GetProduct().GetProductId()) - product_vec.begin();
-
-	if (index < product_vec.size()) {
-		product_vec.erase(product_vec.begin() + index);
-		algo_stream_vec.erase(algo_stream_vec.begin() + index);
-	}
-
-	product_vec.push_back(stream.GetPriceStream().GetProduct().GetProductId());
-	algo_stream_vec.push_back(stream);
+	const PriceStream<Bond> ps = stream.GetPriceStream();
+	algo_stream_store.Put(ps.GetProductIndex(), ps.GetProduct().GetProductId(), stream);
 
 	for (int i = 0; i < listeners.size(); i++) {
 		listeners[i]->ProcessAdd(stream);
@@ -131,10 +123,9 @@ BondPricingServiceListener::BondPricingServiceListener(BondAlgoStreamingService*
 // Listener callback to process an add event to the Service
 void BondPricingServiceListener::ProcessAdd(Price<Bond>& data) {
 
-	double spread = data.GetBidOfferSpread();
-	double mid = data.GetMid();
+	TickPrice spread = data.GetBidOfferSpread();
+	TickPrice mid = data.GetMid();
 
-	Bond b = data.GetProduct();
 	PriceStreamOrder bid(mid - spread / 2, vis_qty, vis_qty * 2, BID);
 	PriceStreamOrder offer(mid + spread / 2, vis_qty, vis_qty * 2, OFFER);
 
@@ -145,7 +136,7 @@ void BondPricingServiceListener::ProcessAdd(Price<Bond>& data) {
 		vis_qty = 1000000;
 	}
 
-	PriceStream<Bond> ps(b, bid, offer);
+	PriceStream<Bond> ps(data.GetProduct(), bid, offer);
 	algostream_service->PublishPrice(ps);
 
 }
@@ -4,25 +4,30 @@
 #ifndef BOND_EXECUTION_SERVICE_HPP
 #define BOND_EXECUTION_SERVICE_HPP
 
+#include <sstream>
 #include "executionservice.hpp"
 #include "bondalgoexecutionservice.hpp"
 #include "bondtradebookingservice.hpp"
+#include "keyedstore.hpp"
 
  //Forward declaration for use in BondExecutionService
 class BondExecutionConnector;
 
-class BondExecutionService : public ExecutionService<Bond>
+template<typename L = DynamicListeners<ExecutionOrder<Bond> > >
+class BasicBondExecutionService : public ExecutionService<Bond>
 {
 private:
 	
-	vector<string> product_vec;
-	vector<ExecutionOrder<Bond> > exe_vec;
-	vector<ServiceListener<ExecutionOrder<Bond> >* > listeners;
+	ProductStore<ExecutionOrder<Bond> > exe_store;
+	L listeners;
 	BondExecutionConnector* exe_connector;
 
 public:
 
-	BondExecutionService(BondExecutionConnector*);
+	BasicBondExecutionService(BondExecutionConnector*);
+
+	// ctor wiring the listeners up front, needed for a StaticListeners set
+	BasicBondExecutionService(BondExecutionConnector*, const L& listeners_);
 
 	// Get data on our service given a key
 	ExecutionOrder<Bond> GetData(string);
@@ -42,14 +47,17 @@ public:
 
 };
 
-class BondAlgoExecutionServiceListener: public ServiceListener<AlgoExecution<Bond> >
+typedef BasicBondExecutionService<> BondExecutionService;
+
+template<typename S = BondExecutionService>
+class BasicBondAlgoExecutionServiceListener: public ServiceListener<AlgoExecution<Bond> >
 {
 private:
-	BondExecutionService* exe_service;
+	S* exe_service;
 
 public:
 
-	BondAlgoExecutionServiceListener(BondExecutionService*);
+	BasicBondAlgoExecutionServiceListener(S*);
 
 	// Listener callback to process an add event to the Service
 	void ProcessAdd(AlgoExecution<Bond>& data);
@@ -62,15 +70,18 @@ public:
 
 };
 
-class BondExecutionServiceListener : public ServiceListener<ExecutionOrder<Bond> >
+typedef BasicBondAlgoExecutionServiceListener<> BondAlgoExecutionServiceListener;
+
+template<typename S = BondTradeBookingService>
+class BasicBondExecutionServiceListener : public ServiceListener<ExecutionOrder<Bond> >
 {
 private:
-	BondTradeBookingService* btb_service;
+	S* btb_service;
 	std::string book;
 
 public:
 
-	BondExecutionServiceListener(BondTradeBookingService*);
+	BasicBondExecutionServiceListener(S*);
 
 	// Listener callback to process an add event to the Service
 	void ProcessAdd(ExecutionOrder<Bond>& data);
@@ -83,60 +94,62 @@ public:
 
 };
 
+typedef BasicBondExecutionServiceListener<> BondExecutionServiceListener;
+
 // Connector subscribing data from marketdata.txt to BondMarketDataService.
 class BondExecutionConnector : public Connector<ExecutionOrder<Bond> >
 {
 
 private:
 
-	BondExecutionService* exe_service;
+	Service<string, ExecutionOrder<Bond> >* exe_service;
 
 public:
 
 	BondExecutionConnector();
 
-	BondExecutionConnector(BondExecutionService*);
+	BondExecutionConnector(Service<string, ExecutionOrder<Bond> >*);
 
 	// Publish data to the Connector
 	void Publish(ExecutionOrder<Bond>&);
 
 	void Subscribe();
 
-	setBondExecutionService(BondExecutionService*);
+	void setBondExecutionService(Service<string, ExecutionOrder<Bond> >*);
 
 };
 
-BondExecutionService::BondExecutionService(BondExecutionConnector* exe_connector_) {
+template<typename L>
+BasicBondExecutionService<L>::BasicBondExecutionService(BondExecutionConnector* exe_connector_) {
+	exe_connector = exe_connector_;
+}
+
+template<typename L>
+BasicBondExecutionService<L>::BasicBondExecutionService(BondExecutionConnector* exe_connector_, const L& listeners_) :
+	listeners(listeners_)
+{
 	exe_connector = exe_connector_;
 }
 
 // Get data on our service given a key
-ExecutionOrder<Bond> BondExecutionService::GetData(string product_id) {
-	int index = find(product_vec.begin(), product_vec.end(), product_id) - product_vec.begin();
-	return exe_vec[index];
+template<typename L>
+ExecutionOrder<Bond> BasicBondExecutionService<L>::GetData(string product_id) {
+	return *exe_store.Find(product_id);
 }
 
 // The callback that a Connector should invoke for any new or updated data
-void BondExecutionService::OnMessage(ExecutionOrder<Bond>& exe) {
+template<typename L>
+void BasicBondExecutionService<L>::OnMessage(ExecutionOrder<Bond>& exe) {
 	
-	int index = find(product_vec.begin(), product_vec.end(), exe.GetProduct().GetProductId()) - product_vec.begin();
-
-	if (index < product_vec.size()) {
-		product_vec.erase(product_vec.begin() + index);
-		exe_vec.erase(exe_vec.begin() + index);
-	}
+	exe_store.Put(exe.GetProductIndex(), exe.GetProduct().GetProductId(), exe);
 
-	product_vec.push_back(exe.GetProduct().GetProductId());
-	exe_vec.push_back(exe);
-
-	for (int i = 0; i < listeners.size(); i++) {
-		listeners[i]->ProcessAdd(exe);
-	}
+	listeners.ProcessAdd(exe);
 
 }
 
 // Execute an order on a market
-void BondExecutionService::ExecuteOrder(const ExecutionOrder<Bond>& order, Market market) {
+template<typename L>
+void BasicBondExecutionService<L>::ExecuteOrder(const ExecutionOrder<Bond>& order, Market market) {
 	ExecutionOrder<Bond> ord = order;
 	OnMessage(ord);
 	exe_connector->Publish(ord);
@@ -144,38 +157,46 @@ void BondExecutionService::ExecuteOrder(const ExecutionOrder<Bond>& order, Marke
 
 // Add a listener to the Service for callbacks on add, remove, and update events
 // for data to the Service.
-void BondExecutionService::AddListener(ServiceListener<ExecutionOrder<Bond> >* listener) {
-	listeners.push_back(listener);
+template<typename L>
+void BasicBondExecutionService<L>::AddListener(ServiceListener<ExecutionOrder<Bond> >* listener) {
+	listeners.Add(listener);
 }
 
 // Get all listeners on the Service.
-const vector<ServiceListener<ExecutionOrder<Bond> >*>& BondExecutionService::GetListeners() const {
-	return listeners;
+template<typename L>
+const vector<ServiceListener<ExecutionOrder<Bond> >*>& BasicBondExecutionService<L>::GetListeners() const {
+	return listeners.Get();
 }
 
-BondAlgoExecutionServiceListener::BondAlgoExecutionServiceListener(BondExecutionService* exe_service_) {
+template<typename S>
+BasicBondAlgoExecutionServiceListener<S>::BasicBondAlgoExecutionServiceListener(S* exe_service_) {
 	exe_service = exe_service_;
 }
 
 // Listener callback to process an add event to the Service
-void BondAlgoExecutionServiceListener::ProcessAdd(AlgoExecution<Bond>& data) {
+template<typename S>
+void BasicBondAlgoExecutionServiceListener<S>::ProcessAdd(AlgoExecution<Bond>& data) {
 	exe_service->ExecuteOrder(data.GetExecutionOrder(), data.GetMarket());
 }
 
 // Listener callback to process a remove event to the Service
-void BondAlgoExecutionServiceListener::ProcessRemove(AlgoExecution<Bond>& data) {}
+template<typename S>
+void BasicBondAlgoExecutionServiceListener<S>::ProcessRemove(AlgoExecution<Bond>& data) {}
 
 // Listener callback to process an update event to the Service
-void BondAlgoExecutionServiceListener::ProcessUpdate(AlgoExecution<Bond>& data) {}
+template<typename S>
+void BasicBondAlgoExecutionServiceListener<S>::ProcessUpdate(AlgoExecution<Bond>& data) {}
 
 
-BondExecutionServiceListener::BondExecutionServiceListener(BondTradeBookingService* btb_service_) {
+template<typename S>
+BasicBondExecutionServiceListener<S>::BasicBondExecutionServiceListener(S* btb_service_) {
 	btb_service = btb_service_;
 	book = "TRSY1";
 }
 
 // Listener callback to process an add event to the Service
-void BondExecutionServiceListener::ProcessAdd(ExecutionOrder<Bond>& data) {
+template<typename S>
+void BasicBondExecutionServiceListener<S>::ProcessAdd(ExecutionOrder<Bond>& data) {
 
 	//No access to std::to_string - setting constant trade id
 	Trade<Bond> t(data.GetProduct(), "Trade_ID", data.GetPrice(), book, data.GetVisibleQuantity() + data.GetHiddenQuantity(), data.GetSide() == BID ? BUY : SELL);
@@ -195,14 +216,16 @@ void BondExecutionServiceListener::ProcessAdd(ExecutionOrder<Bond>& data) {
 }
 
 // Listener callback to process a remove event to the Service
-void BondExecutionServiceListener::ProcessRemove(ExecutionOrder<Bond>& data) {}
+template<typename S>
+void BasicBondExecutionServiceListener<S>::ProcessRemove(ExecutionOrder<Bond>& data) {}
 
 // Listener callback to process an update event to the Service
-void BondExecutionServiceListener::ProcessUpdate(ExecutionOrder<Bond>& data) {}
+template<typename S>
+void BasicBondExecutionServiceListener<S>::ProcessUpdate(ExecutionOrder<Bond>& data) {}
 
 BondExecutionConnector::BondExecutionConnector() {}
 
-BondExecutionConnector::BondExecutionConnector(BondExecutionService* exe_service_) {
+BondExecutionConnector::BondExecutionConnector(Service<string, ExecutionOrder<Bond> >* exe_service_) {
 	exe_service = exe_service_;
 }
 
@@ -211,21 +234,26 @@ void BondExecutionConnector::Publish(ExecutionOrder<Bond>& ord) {
 
 	std::string side = ord.GetSide() == BID ? "BID" : "OFFER";
 
-	std::cout << "Executing Order: " << std::endl;
+	//Built up first and written in one call so lines stay whole when stages run on their own threads
+	std::ostringstream out;
+
+	out << "Executing Order: " << std::endl;
+
+	out << "Bond: " << ord.GetProduct().GetProductId() << ", ";
+	out << "OrderID: " << ord.GetOrderId() << ", ";
+	out << "OrderType: Market, ";
+	out << "OrderSide: " << side << ", ";
+	out << "Price: " << ord.GetPrice() << ", ";
+	out << "Quantiy: " << ord.GetVisibleQuantity() + ord.GetHiddenQuantity() << std::endl;
 
-	std::cout << "Bond: " << ord.GetProduct().GetProductId() << ", ";
-	std::cout << "OrderID: " << ord.GetOrderId() << ", ";
-	std::cout << "OrderType: Market, ";
-	std::cout << "OrderSide: " << side << ", ";
-	std::cout << "Price: " << ord.GetPrice() << ", ";
-	std::cout << "Quantiy: " << ord.GetVisibleQuantity() + ord.GetHiddenQuantity() << std::endl;
+	out << "Order Executed" << std::endl;
 
-	std::cout << "Order Executed" << std::endl;
+	std::cout << out.str() << std::flush;
 }
 
 void BondExecutionConnector::Subscribe() {}
 
-BondExecutionConnector::setBondExecutionService(BondExecutionService* exe_service_) {
+void BondExecutionConnector::setBondExecutionService(Service<string, ExecutionOrder<Bond> >* exe_service_) {
 	exe_service = exe_service_;
 }
 
@@ -10,6 +10,7 @@
 #include "bondriskservice.hpp"
 #include "bondinquiryservice.hpp"
 #include "bondexecutionservice.hpp"
+#include "keyedstore.hpp"
 
 template <typename T>
 class BondHistoricalDataConnector;
@@ -19,8 +20,7 @@ class BondHistoricalDataService : public HistoricalDataService<T>
 {
 private:
 	
-	vector<string> product_vec;
-	vector<T > data_vec;
+	ProductStore<T> data_store;
 	vector<ServiceListener<T>* > listeners;
 	BondHistoricalDataConnector<T>* connector;
 
@@ -44,6 +44,9 @@ public:
 	// Persist data to a store
 	void PersistData(string persistKey, T& data);
 
+	// Persist a batch of data to the store in one write
+	void PersistDataBatch(T* data, size_t count);
+
 };
 
 template <typename T>
@@ -59,6 +62,9 @@ public:
 	// Listener callback to process an add event to the Service
 	void ProcessAdd(T& data);
 
+	// Listener callback to process a batch of add events to the Service
+	void ProcessAddBatch(T* data, size_t count);
+
 	// Listener callback to process a remove event to the Service
 	void ProcessRemove(T& data);
 
@@ -75,11 +81,18 @@ private:
 
 	BondHistoricalDataService<T>* service;
 
-	void publish_data(ExecutionOrder<Bond>&);
-	void publish_data(Inquiry<Bond>&);
-	void publish_data(Position<Bond>&);
-	void publish_data(PriceStream<Bond>&);
-	void publish_data(PV01<Bond>&);
+	//File each data type is persisted to
+	static const char* file_name(const ExecutionOrder<Bond>*);
+	static const char* file_name(const Inquiry<Bond>*);
+	static const char* file_name(const Position<Bond>*);
+	static const char* file_name(const PriceStream<Bond>*);
+	static const char* file_name(const PV01<Bond>*);
+
+	void publish_data(std::ostream&, ExecutionOrder<Bond>&);
+	void publish_data(std::ostream&, Inquiry<Bond>&);
+	void publish_data(std::ostream&, Position<Bond>&);
+	void publish_data(std::ostream&, PriceStream<Bond>&);
+	void publish_data(std::ostream&, PV01<Bond>&);
 
 public:
 
@@ -90,6 +103,9 @@ public:
 	// Publish data to the Connector
 	void Publish(T&);
 
+	// Publish a batch of data, opening the file once for all of it
+	void PublishBatch(T*, size_t);
+
 	void Subscribe();
 
 	void setBondService(BondHistoricalDataService<T>*);
@@ -104,22 +120,13 @@ BondHistoricalDataService<T>::BondHistoricalDataService(BondHistoricalDataConnec
 
 template <typename T>
 T BondHistoricalDataService<T>::GetData(string id) {
-	int index = find(product_vec.begin(), product_vec.end(), id) - product_vec.begin();
-	return data_vec[index];
+	return *data_store.Find(id);
 }
 
 template <typename T>
 void BondHistoricalDataService<T>::OnMessage(T& data) {
 
-	int index = find(product_vec.begin(), product_vec.end(), data.GetProduct().GetProductId()) - product_vec.begin();
-
-	if (index < product_vec.size()) {
-		product_vec.erase(product_vec.begin() + index);
-		data_vec.erase(data_vec.begin() + index);
-	}
-
-	product_vec.push_back(data.GetProduct().GetProductId());
-	data_vec.push_back(data);
+	data_store.Put(data.GetProductIndex(), data.GetProduct().GetProductId(), data);
 
 	for (int i = 0; i < listeners.size(); i++) {
 		listeners[i]->ProcessAdd(data);
@@ -142,6 +149,11 @@ void BondHistoricalDataService<T>::PersistData(string persistKey, T& data) {
 	connector->Publish(data);
 }
 
+template <typename T>
+void BondHistoricalDataService<T>::PersistDataBatch(T* data, size_t count) {
+	connector->PublishBatch(data, count);
+}
+
 template <typename T>
 ServiceListenerToHistorical<T>::ServiceListenerToHistorical(BondHistoricalDataService<T>* service_) {
 	service = service_;
@@ -152,6 +164,11 @@ void ServiceListenerToHistorical<T>::ProcessAdd(T& data) {
 	service->PersistData("", data);
 }
 
+template <typename T>
+void ServiceListenerToHistorical<T>::ProcessAddBatch(T* data, size_t count) {
+	service->PersistDataBatch(data, count);
+}
+
 template <typename T>
 void ServiceListenerToHistorical<T>::ProcessRemove(T& data) {}
 
@@ -177,7 +194,20 @@ BondHistoricalDataConnector<T>::BondHistoricalDataConnector(BondHistoricalDataSe
 
 template <typename T>
 void BondHistoricalDataConnector<T>::Publish(T& data) {
-	publish_data(data);
+	PublishBatch(&data, 1);
+}
+
+template <typename T>
+void BondHistoricalDataConnector<T>::PublishBatch(T* data, size_t count) {
+
+	std::ofstream output;
+	output.open(file_name((T*) NULL), ios::app);
+
+	for (size_t i = 0; i < count; i++) {
+		publish_data(output, data[i]);
+	}
+
+	output.close();
 }
 
 template <typename T>
@@ -189,11 +219,33 @@ void BondHistoricalDataConnector<T>::setBondService(BondHistoricalDataService<T>
 }
 
 template <typename T>
-void BondHistoricalDataConnector<T>::publish_data(ExecutionOrder<Bond>& data) {
-	
-	std::ofstream output;
-	output.open("historical_executions.txt", ios::app);
+const char* BondHistoricalDataConnector<T>::file_name(const ExecutionOrder<Bond>*) {
+	return "historical_executions.txt";
+}
+
+template <typename T>
+const char* BondHistoricalDataConnector<T>::file_name(const Inquiry<Bond>*) {
+	return "historical_inquiries.txt";
+}
 
+template <typename T>
+const char* BondHistoricalDataConnector<T>::file_name(const Position<Bond>*) {
+	return "historical_positions.txt";
+}
+
+template <typename T>
+const char* BondHistoricalDataConnector<T>::file_name(const PriceStream<Bond>*) {
+	return "historical_streaming.txt";
+}
+
+template <typename T>
+const char* BondHistoricalDataConnector<T>::file_name(const PV01<Bond>*) {
+	return "historical_risk.txt";
+}
+
+template <typename T>
+void BondHistoricalDataConnector<T>::publish_data(std::ostream& output, ExecutionOrder<Bond>& data) {
+	
 	std::string side = data.GetSide() == BID ? "BID" : "OFFER";
 	std::string child = data.IsChildOrder() ? "true" : "false";
 
@@ -207,12 +259,11 @@ void BondHistoricalDataConnector<T>::publish_data(ExecutionOrder<Bond>& data) {
 	output << data.GetParentOrderId() << ",";
 	output << child;
 
-	output << std::endl;
-	output.close();
+	output << "\n";
 }
 
 template <typename T>
-void BondHistoricalDataConnector<T>::publish_data(Inquiry<Bond>& data) {
+void BondHistoricalDataConnector<T>::publish_data(std::ostream& output, Inquiry<Bond>& data) {
 
 	std::string side = data.GetSide() == BUY ? "BUY" : "SELL";
 	InquiryState istate = data.GetState();
@@ -234,9 +285,6 @@ void BondHistoricalDataConnector<T>::publish_data(Inquiry<Bond>& data) {
 		state = "CUSTOMER_REJECTED";
 	}
 
-	std::ofstream output;
-	output.open("historical_inquiries.txt", ios::app);
-
 	output << data.GetInquiryId() << ",";
 	output << data.GetProduct().GetProductId() << ",";
 	output << side << ",";
@@ -244,39 +292,31 @@ void BondHistoricalDataConnector<T>::publish_data(Inquiry<Bond>& data) {
 	output << data.GetPrice() << ",";
 	output << state;
 
-	output << std::endl;
-	output.close();
+	output << "\n";
 }
 
 template <typename T>
-void BondHistoricalDataConnector<T>::publish_data(Position<Bond>& data) {
+void BondHistoricalDataConnector<T>::publish_data(std::ostream& output, Position<Bond>& data) {
 
 	std::string book_one("TRSY1");
 	std::string book_two("TRSY2");
 	std::string book_three("TRSY3");
 
-	std::ofstream output;
-	output.open("historical_positions.txt", ios::app);
-
 	output << data.GetProduct().GetProductId() << ",";
 	output << data.GetPosition(book_one) << ",";
 	output << data.GetPosition(book_two) << ",";
 	output << data.GetPosition(book_three) << ",";
 	output << data.GetAggregatePosition();
 
-	output << std::endl;
-	output.close();
+	output << "\n";
 }
 
 template <typename T>
-void BondHistoricalDataConnector<T>::publish_data(PriceStream<Bond>& data) {
+void BondHistoricalDataConnector<T>::publish_data(std::ostream& output, PriceStream<Bond>& data) {
 
 	PriceStreamOrder bid = data.GetBidOrder();
 	PriceStreamOrder offer = data.GetOfferOrder();
 
-	std::ofstream output;
-	output.open("historical_streaming.txt", ios::app);
-
 	output << data.GetProduct() << ",";
 	output << "BID,";
 	output << bid.GetPrice() << ",";
@@ -287,22 +327,17 @@ void BondHistoricalDataConnector<T>::publish_data(PriceStream<Bond>& data) {
 	output << offer.GetVisibleQuantity() << ",";
 	output << offer.GetHiddenQuantity() << ",";
 
-	output << std::endl;
-	output.close();
+	output << "\n";
 }
 
 template <typename T>
-void BondHistoricalDataConnector<T>::publish_data(PV01<Bond>& data) {
-
-	std::ofstream output;
-	output.open("historical_risk.txt", ios::app);
+void BondHistoricalDataConnector<T>::publish_data(std::ostream& output, PV01<Bond>& data) {
 
 	output << data.GetProduct().GetProductId() << ",";
 	output << data.GetPV01() << ",";
 	output << data.GetQuantity();
 
-	output << std::endl;
-	output.close();
+	output << "\n";
 }
 
 #endif
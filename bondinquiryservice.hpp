@@ -7,7 +7,10 @@
 #include "treasuryprices.hpp"
 #include "inquiryservice.hpp"
 #include "bonduniverseservice.hpp"
+#include "keyedstore.hpp"
 #include "util.hpp"
+#include "mappedfile.hpp"
+#include "tokenizer.hpp"
 
 //Forward declaration for use in BondInquiryService
 class BondInquiryConnector;
@@ -16,9 +19,9 @@ class BondInquiryService : public InquiryService<Bond>
 {
 private:
 
-	vector<string> product_vec;
-	vector<string> inquiry_id_vec;
-	vector<Inquiry<Bond> > inq_vec;
+	ProductStore<Inquiry<Bond> > inq_store;
+	//Inquiry id to the product index its inquiry is stored under
+	KeyedStore<string, int> inquiry_products;
 	vector<ServiceListener<Inquiry<Bond> >* > listeners;
 	BondInquiryConnector* bic;
 
@@ -88,8 +91,8 @@ public:
 	// Subscribe to prices.txt
 	void Subscribe();
 
-	setBondInquiryService(BondInquiryService*);
-	setBondUniverseService(BondUniverseService*);
+	void setBondInquiryService(BondInquiryService*);
+	void setBondUniverseService(BondUniverseService*);
 
 };
 
@@ -99,29 +102,18 @@ BondInquiryService::BondInquiryService(BondInquiryConnector* bic_) {
 
 // Get data on our service given a key
 Inquiry<Bond> BondInquiryService::GetData(string product_id) {
-	int index = find(product_vec.begin(), product_vec.end(), product_id) - product_vec.begin();
-	return inq_vec[index];
+	return *inq_store.Find(product_id);
 }
 
 // The callback that a Connector should invoke for any new or updated data
 void BondInquiryService::OnMessage(Inquiry<Bond>& inquiry) {
 
-	int index = find(product_vec.begin(), product_vec.end(), inquiry.GetProduct().GetProductId()) - product_vec.begin();
-
-	if (index < product_vec.size()) {
-		product_vec.erase(product_vec.begin() + index);
-		inq_vec.erase(inq_vec.begin() + index);
-		inquiry_id_vec.erase(inquiry_id_vec.begin() + index);
-
-	}
-
 	if (inquiry.GetState() == QUOTED) {
 		inquiry.SetState(DONE);
 	}
 
-	product_vec.push_back(inquiry.GetProduct().GetProductId());
-	inq_vec.push_back(inquiry);
-	inquiry_id_vec.push_back(inquiry.GetInquiryId());
+	inq_store.Put(inquiry.GetProductIndex(), inquiry.GetProduct().GetProductId(), inquiry);
+	inquiry_products.Put(inquiry.GetInquiryId(), inquiry.GetProductIndex());
 
 
 	for (int i = 0; i < listeners.size(); i++) {
@@ -144,9 +136,7 @@ const vector<ServiceListener<Inquiry<Bond> >*>& BondInquiryService::GetListeners
 // Send a quote back to the client
 void BondInquiryService::SendQuote(const string& inquiryId, double price) {
 	
-	int index = find(inquiry_id_vec.begin(), inquiry_id_vec.end(), inquiryId) - inquiry_id_vec.begin();
-	
-	Inquiry<Bond> inquiry = inq_vec[index];
+	Inquiry<Bond> inquiry = *inq_store.Find(*inquiry_products.Find(inquiryId));
 	
 	inquiry.SetPrice(price);
 	
@@ -157,8 +147,7 @@ void BondInquiryService::SendQuote(const string& inquiryId, double price) {
 // Reject an inquiry from the client
 void BondInquiryService::RejectInquiry(const string& inquiryId) {
 
-	int index = find(inquiry_id_vec.begin(), inquiry_id_vec.end(), inquiryId) - inquiry_id_vec.begin();
-	inq_vec[index].SetState(REJECTED);
+	inq_store.Find(*inquiry_products.Find(inquiryId))->SetState(REJECTED);
 }
 
 BondInquiryServiceListener::BondInquiryServiceListener(BondInquiryService* service_) {
@@ -186,10 +175,10 @@ BondInquiryConnector::BondInquiryConnector(BondInquiryService* inq_service_, Bon
 	uni_service = uni_service_;
 }
 
-BondInquiryConnector::setBondInquiryService(BondInquiryService* inq_service_) {
+void BondInquiryConnector::setBondInquiryService(BondInquiryService* inq_service_) {
 	inq_service = inq_service_;
 }
-BondInquiryConnector::setBondUniverseService(BondUniverseService* uni_service_) {
+void BondInquiryConnector::setBondUniverseService(BondUniverseService* uni_service_) {
 	uni_service = uni_service_;
 }
 
@@ -200,21 +189,27 @@ void BondInquiryConnector::Publish(Inquiry<Bond>& data) {
 
 void BondInquiryConnector::Subscribe() {
 
-	ifstream input_file;
-	input_file.open("inquiries.txt");
-	string update;
+	MappedFile input_file("inquiries.txt");
+	Tokenizer tokenizer(input_file);
+	vector<StringView> update_split;
 
-	Bond b;
 	TreasuryPrices price;
 	long quantity;
 	InquiryState state;
 
-	while (getline(input_file, update)) {
+	while (tokenizer.NextLine(update_split)) {
 
-		vector<string> update_split = split(update, ",");
+		if (update_split.size() < 6) {
+			continue;
+		}
+
+		const Bond* b = uni_service->FindBond(update_split[1]);
+
+		if (b == NULL) {
+			continue;
+		}
 
-		b = uni_service->GetData(update_split[1]);
-		std::sscanf(update_split[3].c_str(), "%d", &quantity);
+		quantity = parse_long(update_split[3]);
 		price = TreasuryPrices(update_split[4]);
 
 		if (update_split[5] == "RECEIVED") {
@@ -233,7 +228,7 @@ void BondInquiryConnector::Subscribe() {
 			state = CUSTOMER_REJECTED;
 		}
 
-		Inquiry<Bond> t(update_split[0], b, update_split[2] == "BUY" ? BUY : SELL, quantity, price.toDouble(), state);
+		Inquiry<Bond> t(update_split[0].str(), *b, update_split[2] == "BUY" ? BUY : SELL, quantity, price.toDouble(), state);
 		inq_service->OnMessage(t);
 	}
 }
@@ -6,59 +6,251 @@
 
 #include <string>
 #include <vector>
-#include <map>
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include "soa.hpp"
+#include "keyedstore.hpp"
 #include "treasuryprices.hpp"
 #include "marketdataservice.hpp"
 #include "bonduniverseservice.hpp"
 #include "products.hpp"
 #include "util.hpp"
+#include "marketdatatext.hpp"
+#include "marketdatabinary.hpp"
+#include "depthladder.hpp"
+#include "consolidatedbook.hpp"
 
-class BondMarketDataService : public Service<string,OrderBook <Bond> >
+//One level change to the book of a product
+struct LevelDelta
+{
+	const Bond* product;
+	LevelAction action;
+	PricingSide side;
+	TickPrice price;
+	long quantity;
+	//Sequence number of the update, set on its UPDATE_END
+	unsigned long long sequence;
+};
+
+//Takes level deltas from a connector, implemented by services keeping books incrementally
+class LevelDeltaSink
+{
+public:
+
+	// Apply deltas in order, publishing each book as its UPDATE_END arrives
+	virtual void OnDeltas(const LevelDelta* deltas, size_t count) = 0;
+
+};
+
+//Takes whole books of one venue from a connector, implemented by services consolidating venues
+class VenueBookSink
+{
+public:
+
+	// Replace product's book on venue and publish the consolidated book, stacks best price
+	// first with one order per price
+	virtual void OnVenueBook(Market venue, const Bond& product, const vector<Order>& bid_stack, const vector<Order>& offer_stack) = 0;
+
+};
+
+//Takes the books of a snapshot from a connector recovering from one
+class SnapshotSink
+{
+public:
+
+	// Replace the stored books with a snapshot's, taken after message sequence, without
+	// publishing them
+	virtual void OnSnapshot(const OrderBook<Bond>* obs, size_t count, unsigned long long sequence) = 0;
+
+};
+
+//Tells a service snapshotting its books where the messages it applied came from
+class SnapshotOriginSource
+{
+public:
+
+	// Origin of the source read up to and including message sequence, false if unknown
+	virtual bool GetOrigin(unsigned long long sequence, SnapshotOrigin& origin) = 0;
+
+};
+
+//Levels per side reserved in a book built from deltas
+const size_t BOOK_RESERVED_LEVELS = 16;
+
+//Best price first for the side, bids descending and offers ascending
+bool bid_before(const Order& a, const Order& b) {
+	return a.GetPrice() > b.GetPrice();
+}
+
+bool offer_before(const Order& a, const Order& b) {
+	return a.GetPrice() < b.GetPrice();
+}
+
+// Sort levels best price first and fold repeated prices into one level
+void normalize_levels(vector<Order>& levels, PricingSide side) {
+
+	if (!is_sorted(levels.begin(), levels.end(), side == BID ? bid_before : offer_before)) {
+		stable_sort(levels.begin(), levels.end(), side == BID ? bid_before : offer_before);
+	}
+
+	size_t out = 0;
+
+	for (size_t k = 0; k < levels.size(); k++) {
+		if (out > 0 && levels[out - 1].GetPrice() == levels[k].GetPrice()) {
+			levels[out - 1] = Order(levels[k].GetPrice(), levels[out - 1].GetQuantity() + levels[k].GetQuantity(), side);
+		}
+		else {
+			levels[out++] = levels[k];
+		}
+	}
+
+	levels.resize(out, Order(TickPrice(), 0, side));
+}
+
+template<typename L = DynamicListeners<OrderBook<Bond> > >
+class BasicBondMarketDataService : public Service<string,OrderBook <Bond> >, public LevelDeltaSink, public VenueBookSink, public SnapshotSink
 {
 private:
 
-	vector<string> product_vec;
-	vector<OrderBook<Bond> > ob_vec;
-	//map<string, OrderBook<Bond> > product_ob_map;
-	vector<ServiceListener<OrderBook<Bond> >* > listeners;
+	ProductStore<OrderBook<Bond> > ob_store;
+	L listeners;
+
+	//Notified only when the best bid or offer moves, and the top last published per product
+	DynamicListeners<OrderBook<Bond> > top_listeners;
+	ProductStore<BidOffer> published_tops;
+
+	// Flag the sides of ob whose top differs from the last one published for the product
+	void MarkTopOfBookChange(OrderBook<Bond>& ob);
+
+	//Reused by every AggregateDepth call
+	DepthLadder depth_ladder;
+
+	//Per venue books merged per product, for products fed through OnVenueBook
+	ProductStore<ConsolidatedBook<Bond> > consolidated_books;
+
+	//Sequence of the last message applied, and where and how often the books are snapshotted
+	unsigned long long sequence;
+	string snapshot_path;
+	unsigned long long snapshot_interval;
+	unsigned long long next_snapshot;
+	SnapshotOriginSource* origin_source;
+
+	// Snapshot the books once sequence reaches the next snapshot
+	void CheckSnapshot();
 
 public:
 
+	BasicBondMarketDataService();
+
+	// ctor wiring the listeners up front, needed for a StaticListeners set
+	BasicBondMarketDataService(const L& listeners_);
+
 	// Get data on our service given a key
 	OrderBook<Bond> GetData(string product_id);
 
 	// The callback that a Connector should invoke for any new or updated data
 	void OnMessage(OrderBook<Bond>& ob);
 
+	// Store a batch of order books, then hand the whole batch to each listener
+	void OnMessageBatch(OrderBook<Bond>* obs, size_t count);
+
+	// Apply level deltas to the stored books in place, handing each book to the listeners
+	// once its update is complete
+	void OnDeltas(const LevelDelta* deltas, size_t count);
+
+	// Merge a venue's book into the product's consolidated book, storing and publishing the
+	// consolidated book as the product's book
+	void OnVenueBook(Market venue, const Bond& product, const vector<Order>& bid_stack, const vector<Order>& offer_stack);
+
 	// Add a listener to the Service for callbacks on add, remove, and update events
 	// for data to the Service.
 	void AddListener(ServiceListener<OrderBook<Bond> >* listener);
 
+	// Add a listener called only for books whose best bid or offer price or size changed,
+	// GetTopOfBookChange on the book telling it which side
+	void AddTopOfBookListener(ServiceListener<OrderBook<Bond> >* listener);
+
 	// Get all listeners on the Service.
 	const vector<ServiceListener<OrderBook<Bond> >* >& GetListeners() const;
 
-	// Get the best bid/offer order
-	const BidOffer GetBestBidOffer(const string &productId);
+	// Get the best bid/offer order, maintained with the book rather than found by a scan
+	const BidOffer& GetBestBidOffer(const string &productId);
+
+	// Get the best bid/offer order by dense product index
+	const BidOffer& GetBestBidOffer(int productIndex);
+
+	// Aggregate the order book, quantity summed per price with both sides in ascending price.
+	// The view points into arrays reused by the next call.
+	DepthView AggregateDepth(const string &productId);
+
+	// Get the consolidated books, with the venues showing each price
+	const ProductStore<ConsolidatedBook<Bond> >& GetConsolidatedBooks() const;
+
+	// Snapshot every book to path each interval messages, 0 turning snapshots off. A snapshot
+	// is written beside path and renamed over it, so path always holds a whole one.
+	void EnableSnapshots(const string& path, unsigned long long interval);
+
+	// Set what tells snapshots where the messages came from, the connector feeding the service
+	void SetOriginSource(SnapshotOriginSource* source);
+
+	// Write every book to path with the current sequence and its origin, keeping the best
+	// BINARY_BOOK_LEVELS per side. Nothing is written if the origin is unknown, as such a
+	// snapshot could never be recovered from.
+	void WriteSnapshot(const string& path);
 
-	// Aggregate the order book
-	OrderBook<Bond> AggregateDepth(const string &productId);
+	void OnSnapshot(const OrderBook<Bond>* obs, size_t count, unsigned long long snapshot_sequence);
+
+	// Get the sequence number of the last market data message applied, 0 if none
+	unsigned long long GetSequence() const;
 
 };
 
+typedef BasicBondMarketDataService<> BondMarketDataService;
+
 // Connector subscribing data from marketdata.txt to BondMarketDataService.
-class BondMarketDataConnector : public Connector<OrderBook<Bond> >
+class BondMarketDataConnector : public Connector<OrderBook<Bond> >, public SnapshotOriginSource
 {
 
 private:
 
-	BondMarketDataService* md_service;
+	Service<string, OrderBook<Bond> >* md_service;
+	LevelDeltaSink* delta_sink;
+	VenueBookSink* venue_sink;
+	SnapshotSink* snapshot_sink;
 	BondUniverseService* uni_service;
 
+	//Sequence number of the last message read, the line of marketdata.txt or record of the
+	//binary file, and the byte offset of marketdata.txt after it, where a subscription resumes
+	unsigned long long sequence;
+	size_t offset;
+
+	//Source being read, 0 record_size for text lines, and the message and byte offset the batch
+	//with the service starts after, which GetOrigin locates messages from
+	const char* source;
+	size_t source_size;
+	size_t record_size;
+	unsigned long long batch_sequence;
+	size_t batch_offset;
+
+	// Start reading source, a batch starting after message batch_sequence_ at batch_offset_
+	void BeginSource(const char* source_, size_t source_size_, size_t record_size_, unsigned long long batch_sequence_, size_t batch_offset_);
+
+	//Last levels seen per product index, best price first, which incremental mode diffs against
+	vector<vector<Order> > last_bids;
+	vector<vector<Order> > last_offers;
+
+	// Append the deltas taking one side from last to next, both best price first
+	void DiffLevels(const Bond&, PricingSide, const vector<Order>& last, const vector<Order>& next, vector<LevelDelta>&);
+
 public:
 
-	BondMarketDataConnector(BondMarketDataService*, BondUniverseService*);
+	BondMarketDataConnector(Service<string, OrderBook<Bond> >*, BondUniverseService*);
+
+	// ctor for a service that also takes level deltas, venue books and snapshots, needed for
+	// SubscribeIncremental, SubscribeVenues and Recover
+	template<typename L>
+	BondMarketDataConnector(BasicBondMarketDataService<L>*, BondUniverseService*);
 
 	// Publish data to the Connector
 	void Publish(OrderBook<Bond>&) ;
@@ -66,176 +258,677 @@ public:
 	// Subscribe to marketdata.txt
 	void Subscribe();
 
+	// Subscribe to binary records converted from marketdata.txt, read in place from the mapping
+	void SubscribeBinary(const char* path = "marketdata.bin");
+
+	// Subscribe to marketdata.txt, sending the service only the levels each line changes
+	void SubscribeIncremental();
+
+	// Subscribe to marketdata.txt as books from every venue, each product's lines going to
+	// BROKERTEC, ESPEED and CME in turn since the file carries no venue. Venue books aren't
+	// snapshotted, so this always starts from the first line.
+	void SubscribeVenues();
+
+	// Restore the service's books from a snapshot of source, marketdata.txt or the binary file
+	// to be subscribed, and have the next subscription replay only the messages after it. A
+	// snapshot taken from other data, or with another universe, is ignored. Returns the
+	// snapshot's sequence, 0 without a usable snapshot.
+	unsigned long long Recover(const char* path = "marketdata.snapshot", const char* source_path = "marketdata.txt");
+
+	bool GetOrigin(unsigned long long message_sequence, SnapshotOrigin& origin);
+
 };
 
+template<typename L>
+BasicBondMarketDataService<L>::BasicBondMarketDataService() {
+	sequence = 0;
+	snapshot_interval = 0;
+	next_snapshot = 0;
+	origin_source = NULL;
+}
+
+template<typename L>
+BasicBondMarketDataService<L>::BasicBondMarketDataService(const L& listeners_) :
+	listeners(listeners_)
+{
+	sequence = 0;
+	snapshot_interval = 0;
+	next_snapshot = 0;
+	origin_source = NULL;
+}
+
 // Get data on our service given a key
-OrderBook<Bond> BondMarketDataService::GetData(string product_id) {
-	int index = find(product_vec.begin(), product_vec.end(), product_id) - product_vec.begin();
-	return ob_vec[index];
+template<typename L>
+OrderBook<Bond> BasicBondMarketDataService<L>::GetData(string product_id) {
+	return *ob_store.Find(product_id);
 }
 
 // The callback that a Connector should invoke for any new or updated data
-void BondMarketDataService::OnMessage(OrderBook<Bond>& ob) {
+template<typename L>
+void BasicBondMarketDataService<L>::OnMessage(OrderBook<Bond>& ob) {
+
+	MarkTopOfBookChange(ob);
+
+	ob_store.Put(ob.GetProductIndex(), ob.GetProduct().GetProductId(), ob);
+
+	listeners.ProcessAdd(ob);
+
+	if (ob.GetTopOfBookChange() != TOP_UNCHANGED) {
+		top_listeners.ProcessAdd(ob);
+	}
+
+	sequence = max(sequence, ob.GetSequence());
+	CheckSnapshot();
+}
+
+template<typename L>
+void BasicBondMarketDataService<L>::OnMessageBatch(OrderBook<Bond>* obs, size_t count) {
+
+	for (size_t i = 0; i < count; i++) {
+		MarkTopOfBookChange(obs[i]);
+		ob_store.Put(obs[i].GetProductIndex(), obs[i].GetProduct().GetProductId(), obs[i]);
+	}
+
+	listeners.ProcessAddBatch(obs, count);
+
+	for (size_t i = 0; i < count; i++) {
+		if (obs[i].GetTopOfBookChange() != TOP_UNCHANGED) {
+			top_listeners.ProcessAdd(obs[i]);
+		}
+	}
+
+	if (count > 0) {
+		sequence = max(sequence, obs[count - 1].GetSequence());
+		CheckSnapshot();
+	}
+}
+
+template<typename L>
+void BasicBondMarketDataService<L>::OnDeltas(const LevelDelta* deltas, size_t count) {
+
+	for (size_t i = 0; i < count; i++) {
+
+		const LevelDelta& delta = deltas[i];
+		int index = delta.product->GetProductIndex();
+
+		OrderBook<Bond>* ob = ob_store.Find(index);
+
+		if (ob == NULL) {
+			ob = &ob_store.Put(index, delta.product->GetProductId(), OrderBook<Bond>(*delta.product, vector<Order>(), vector<Order>()));
+			ob->Reserve(BOOK_RESERVED_LEVELS);
+		}
+
+		if (delta.action == UPDATE_END) {
+
+			ob->SetSequence(delta.sequence);
+			MarkTopOfBookChange(*ob);
 
-	int index = find(product_vec.begin(), product_vec.end(), ob.GetProduct().GetProductId()) - product_vec.begin();
+			listeners.ProcessAdd(*ob);
 
-	if (index < product_vec.size()) {
-		product_vec.erase(product_vec.begin() + index);
-		ob_vec.erase(ob_vec.begin() + index);
+			if (ob->GetTopOfBookChange() != TOP_UNCHANGED) {
+				top_listeners.ProcessAdd(*ob);
+			}
+
+			//Only between updates, a batch may end part way through one
+			sequence = max(sequence, delta.sequence);
+			CheckSnapshot();
+		}
+		else {
+			ob->ApplyLevel(delta.side, delta.action, delta.price, delta.quantity);
+		}
+	}
+}
+
+template<typename L>
+void BasicBondMarketDataService<L>::OnVenueBook(Market venue, const Bond& product, const vector<Order>& bid_stack, const vector<Order>& offer_stack) {
+
+	int index = product.GetProductIndex();
+
+	ConsolidatedBook<Bond>* consolidated = consolidated_books.Find(index);
+
+	//The stored book is the merged book, changed level by level along with the consolidated one
+	OrderBook<Bond>* ob = ob_store.Find(index);
+
+	if (consolidated == NULL) {
+		consolidated = &consolidated_books.Put(index, product.GetProductId(), ConsolidatedBook<Bond>(BOOK_RESERVED_LEVELS));
+		ob = &ob_store.Put(index, product.GetProductId(), OrderBook<Bond>(product, vector<Order>(), vector<Order>()));
+		ob->Reserve(BOOK_RESERVED_LEVELS);
 	}
 
-	product_vec.push_back(ob.GetProduct().GetProductId());
-	ob_vec.push_back(ob);
+	consolidated->UpdateVenue(venue, bid_stack, offer_stack, *ob);
+
+	MarkTopOfBookChange(*ob);
+
+	listeners.ProcessAdd(*ob);
 
-	for (int i = 0; i < listeners.size(); i++) {
-		listeners[i]->ProcessAdd(ob);
+	if (ob->GetTopOfBookChange() != TOP_UNCHANGED) {
+		top_listeners.ProcessAdd(*ob);
+	}
+}
+
+template<typename L>
+void BasicBondMarketDataService<L>::MarkTopOfBookChange(OrderBook<Bond>& ob) {
+
+	const BidOffer& top = ob.GetBestBidOffer();
+	BidOffer* published = published_tops.Find(ob.GetProductIndex());
+
+	if (published == NULL) {
+		ob.SetTopOfBookChange(BID_CHANGED | OFFER_CHANGED);
+		published_tops.Put(ob.GetProductIndex(), ob.GetProduct().GetProductId(), top);
+		return;
+	}
+
+	const Order& bid = top.GetBidOrder();
+	const Order& offer = top.GetOfferOrder();
+	const Order& last_bid = published->GetBidOrder();
+	const Order& last_offer = published->GetOfferOrder();
+
+	int change = TOP_UNCHANGED;
+
+	if (bid.GetPrice() != last_bid.GetPrice() || bid.GetQuantity() != last_bid.GetQuantity()) {
+		change |= BID_CHANGED;
+	}
+
+	if (offer.GetPrice() != last_offer.GetPrice() || offer.GetQuantity() != last_offer.GetQuantity()) {
+		change |= OFFER_CHANGED;
+	}
+
+	ob.SetTopOfBookChange(change);
+
+	if (change != TOP_UNCHANGED) {
+		*published = top;
 	}
 }
 
 // Add a listener to the Service for callbacks on add, remove, and update events
 // for data to the Service.
-void BondMarketDataService::AddListener(ServiceListener<OrderBook<Bond> >* listener) {
-	listeners.push_back(listener);
+template<typename L>
+void BasicBondMarketDataService<L>::AddListener(ServiceListener<OrderBook<Bond> >* listener) {
+	listeners.Add(listener);
+}
+
+template<typename L>
+void BasicBondMarketDataService<L>::AddTopOfBookListener(ServiceListener<OrderBook<Bond> >* listener) {
+	top_listeners.Add(listener);
 }
 
 // Get all listeners on the Service.
-const vector<ServiceListener<OrderBook<Bond> >*>& BondMarketDataService::GetListeners() const {
-	return listeners;
+template<typename L>
+const vector<ServiceListener<OrderBook<Bond> >*>& BasicBondMarketDataService<L>::GetListeners() const {
+	return listeners.Get();
 }
 
 // Get the best bid/offer order
-const BidOffer BondMarketDataService::GetBestBidOffer(const string& productId) {
+template<typename L>
+const BidOffer& BasicBondMarketDataService<L>::GetBestBidOffer(const string& productId) {
+	return ob_store.Find(productId)->GetBestBidOffer();
+}
 
-	int index = find(product_vec.begin(), product_vec.end(), productId) - product_vec.begin();
-	vector<Order> bid_stack = ob_vec[index].GetBidStack();
-	vector<Order> offer_stack = ob_vec[index].GetOfferStack();
+template<typename L>
+const BidOffer& BasicBondMarketDataService<L>::GetBestBidOffer(int productIndex) {
+	return ob_store.Find(productIndex)->GetBestBidOffer();
+}
 
-	Order best_bid = bid_stack.front();
-	Order best_offer = offer_stack.front();
+// Aggregate the order book
+template<typename L>
+DepthView BasicBondMarketDataService<L>::AggregateDepth(const string& productId) {
 
-	for (int i = 1; i < bid_stack.size(); i++) {
+	const OrderBook<Bond>& ob = *ob_store.Find(productId);
 
-		if (best_bid.GetPrice() < bid_stack[i].GetPrice()) {
-			best_bid = bid_stack[i];
-		}
+	return depth_ladder.Aggregate(ob.GetBidStack(), ob.GetOfferStack());
+}
 
+template<typename L>
+const ProductStore<ConsolidatedBook<Bond> >& BasicBondMarketDataService<L>::GetConsolidatedBooks() const {
+	return consolidated_books;
+}
+
+template<typename L>
+void BasicBondMarketDataService<L>::EnableSnapshots(const string& path, unsigned long long interval) {
+	snapshot_path = path;
+	snapshot_interval = interval;
+	next_snapshot = interval == 0 ? 0 : (sequence / interval + 1) * interval;
+}
+
+template<typename L>
+void BasicBondMarketDataService<L>::CheckSnapshot() {
+
+	if (snapshot_interval != 0 && sequence >= next_snapshot) {
+		WriteSnapshot(snapshot_path);
+		next_snapshot = (sequence / snapshot_interval + 1) * snapshot_interval;
+	}
+}
+
+template<typename L>
+void BasicBondMarketDataService<L>::SetOriginSource(SnapshotOriginSource* source) {
+	origin_source = source;
+}
+
+template<typename L>
+void BasicBondMarketDataService<L>::WriteSnapshot(const string& path) {
+
+	SnapshotOrigin origin;
+
+	if (origin_source == NULL || !origin_source->GetOrigin(sequence, origin)) {
+		return;
 	}
 
-	for (int i = 1; i < offer_stack.size(); i++) {
+	string partial = path + ".partial";
+	BinaryBookWriter output(partial.c_str(), BINARY_SNAPSHOT_MAGIC);
+	BinaryBook book;
+
+	//Stacks fed whole books are in file order, so the best levels are picked before truncating
+	vector<Order> bid_stack, offer_stack;
 
-		if (best_offer.GetPrice() > offer_stack[i].GetPrice()) {
-			best_offer = offer_stack[i];
+	for (int i = 0; i < ob_store.EndIndex(); i++) {
+
+		const OrderBook<Bond>* ob = ob_store.Find(i);
+
+		if (ob == NULL) {
+			continue;
 		}
 
+		bid_stack = ob->GetBidStack();
+		offer_stack = ob->GetOfferStack();
+		normalize_levels(bid_stack, BID);
+		normalize_levels(offer_stack, OFFER);
+
+		pack_binary_book(book, ob->GetProduct().GetProductId(), bid_stack, offer_stack);
+		output.Write(book);
 	}
 
-	return BidOffer(best_bid, best_offer);
+	output.Close(sequence, origin);
+	rename(partial.c_str(), path.c_str());
 }
 
-// Aggregate the order book
-OrderBook<Bond> BondMarketDataService::AggregateDepth(const string& productId) {
+template<typename L>
+void BasicBondMarketDataService<L>::OnSnapshot(const OrderBook<Bond>* obs, size_t count, unsigned long long snapshot_sequence) {
+
+	for (size_t i = 0; i < count; i++) {
+
+		int index = obs[i].GetProductIndex();
+		const string& product_id = obs[i].GetProduct().GetProductId();
+
+		OrderBook<Bond>& ob = ob_store.Put(index, product_id, obs[i]);
+		ob.Reserve(BOOK_RESERVED_LEVELS);
+
+		//Published as far as the top of book filter is concerned
+		published_tops.Put(index, product_id, ob.GetBestBidOffer());
+	}
+
+	sequence = snapshot_sequence;
+	EnableSnapshots(snapshot_path, snapshot_interval);
+}
+
+template<typename L>
+unsigned long long BasicBondMarketDataService<L>::GetSequence() const {
+	return sequence;
+}
+
+
+BondMarketDataConnector::BondMarketDataConnector(Service<string, OrderBook<Bond> >* md_service_, BondUniverseService* uni_service_) {
+	md_service = md_service_;
+	delta_sink = NULL;
+	venue_sink = NULL;
+	snapshot_sink = NULL;
+	uni_service = uni_service_;
+	sequence = 0;
+	offset = 0;
+	BeginSource(NULL, 0, 0, 0, 0);
+}
+
+template<typename L>
+BondMarketDataConnector::BondMarketDataConnector(BasicBondMarketDataService<L>* md_service_, BondUniverseService* uni_service_) {
+	md_service = md_service_;
+	delta_sink = md_service_;
+	venue_sink = md_service_;
+	snapshot_sink = md_service_;
+	uni_service = uni_service_;
+	sequence = 0;
+	offset = 0;
+	BeginSource(NULL, 0, 0, 0, 0);
+	md_service_->SetOriginSource(this);
+}
 
-	int index = find(product_vec.begin(), product_vec.end(), productId) - product_vec.begin();
-	vector<Order> bid_stack = ob_vec[index].GetBidStack();
-	vector<Order> offer_stack = ob_vec[index].GetOfferStack();
+void BondMarketDataConnector::BeginSource(const char* source_, size_t source_size_, size_t record_size_, unsigned long long batch_sequence_, size_t batch_offset_) {
+	source = source_;
+	source_size = source_size_;
+	record_size = record_size_;
+	batch_sequence = batch_sequence_;
+	batch_offset = batch_offset_;
+}
 
-	map<double, long> price_qty;
+void BondMarketDataConnector::Publish(OrderBook<Bond>& data) {}
 
-	vector<Order> agg_bid_stack;
-	vector<Order> agg_offer_stack;
+void BondMarketDataConnector::Subscribe() {
 
+	//After Recover only the lines following the snapshot are replayed
+	MarketDataTextReader input_file("marketdata.txt", sequence, offset);
+	StringView product_id;
+	vector<Order> bid_stack, offer_stack;
 
-	for (std::vector<Order>::iterator it = bid_stack.begin(); it != bid_stack.end(); it++) {
+	//Books are handed to the service a batch at a time
+	const size_t batch_size = 1024;
+	vector<OrderBook<Bond> > batch;
+	batch.reserve(batch_size);
 
-		if (price_qty.find(it->GetPrice()) != price_qty.end()) {
-			price_qty[it->GetPrice()] += it->GetQuantity();
+	BeginSource(input_file.Data(), input_file.Size(), 0, input_file.Line(), input_file.Offset());
+
+	while (input_file.Next(product_id, bid_stack, offer_stack)) {
+
+		const Bond* product = uni_service->FindBond(product_id);
+
+		if (product == NULL) {
+			continue;
 		}
-		else {
-			price_qty[it->GetPrice()] = it->GetQuantity();
+
+		batch.push_back(OrderBook<Bond>(*product, bid_stack, offer_stack));
+		batch.back().SetSequence(input_file.Line());
+
+		if (batch.size() == batch_size) {
+			md_service->OnMessageBatch(&batch[0], batch.size());
+			batch.clear();
+			BeginSource(input_file.Data(), input_file.Size(), 0, input_file.Line(), input_file.Offset());
 		}
+	}
 
+	if (!batch.empty()) {
+		md_service->OnMessageBatch(&batch[0], batch.size());
 	}
 
-	for (std::map<double,long>::iterator it = price_qty.begin(); it != price_qty.end(); it++) {
-		agg_bid_stack.push_back(Order(it->first, it->second, BID));
+	sequence = input_file.Line();
+	offset = input_file.Offset();
+	BeginSource(NULL, 0, 0, 0, 0);
+}
+
+void BondMarketDataConnector::SubscribeBinary(const char* path) {
+
+	BinaryBookReader input_file(path);
+
+	vector<Order> bid_stack, offer_stack;
+
+	//Books are handed to the service a batch at a time
+	const size_t batch_size = 1024;
+	vector<OrderBook<Bond> > batch;
+	batch.reserve(batch_size);
+
+	//Record r is message r + 1, so any message is located from the first record
+	BeginSource(input_file.Data() + sizeof(BinaryBookHeader), input_file.Count() * sizeof(BinaryBook), sizeof(BinaryBook), 0, 0);
+
+	//Records are numbered like lines, so after Recover replay starts past the snapshot's
+	for (size_t r = sequence; r < input_file.Count(); r++) {
+
+		sequence = r + 1;
+
+		const Bond* product = uni_service->FindBond(input_file.ProductId(r));
+
+		if (product == NULL) {
+			continue;
+		}
+
+		unpack_binary_book(input_file.Record(r), bid_stack, offer_stack);
+
+		batch.push_back(OrderBook<Bond>(*product, bid_stack, offer_stack));
+		batch.back().SetSequence(sequence);
+
+		if (batch.size() == batch_size) {
+			md_service->OnMessageBatch(&batch[0], batch.size());
+			batch.clear();
+		}
+	}
+
+	if (!batch.empty()) {
+		md_service->OnMessageBatch(&batch[0], batch.size());
 	}
 
-	price_qty.clear();
+	BeginSource(NULL, 0, 0, 0, 0);
+}
+
+void BondMarketDataConnector::DiffLevels(const Bond& product, PricingSide side, const vector<Order>& last, const vector<Order>& next, vector<LevelDelta>& deltas) {
+
+	LevelDelta delta;
+	delta.product = &product;
+	delta.side = side;
+
+	size_t i = 0, j = 0;
+
+	//Merge the two ladders, both sorted best price first
+	while (i < last.size() || j < next.size()) {
 
-	for (std::vector<Order>::iterator it = offer_stack.begin(); it != offer_stack.end(); it++) {
+		bool take_last, take_next;
 
-		if (price_qty.find(it->GetPrice()) != price_qty.end()) {
-			price_qty[it->GetPrice()] += it->GetQuantity();
+		if (j == next.size()) {
+			take_last = true;
+			take_next = false;
+		}
+		else if (i == last.size()) {
+			take_last = false;
+			take_next = true;
 		}
 		else {
-			price_qty[it->GetPrice()] = it->GetQuantity();
+			TickPrice a = last[i].GetPrice(), b = next[j].GetPrice();
+			take_last = a == b || (side == BID ? a > b : a < b);
+			take_next = a == b || !take_last;
 		}
 
+		if (take_last && take_next) {
+			if (last[i].GetQuantity() != next[j].GetQuantity()) {
+				delta.action = LEVEL_UPDATE;
+				delta.price = next[j].GetPrice();
+				delta.quantity = next[j].GetQuantity();
+				deltas.push_back(delta);
+			}
+			i++;
+			j++;
+		}
+		else if (take_last) {
+			delta.action = LEVEL_DELETE;
+			delta.price = last[i].GetPrice();
+			delta.quantity = 0;
+			deltas.push_back(delta);
+			i++;
+		}
+		else {
+			delta.action = LEVEL_INSERT;
+			delta.price = next[j].GetPrice();
+			delta.quantity = next[j].GetQuantity();
+			deltas.push_back(delta);
+			j++;
+		}
 	}
+}
 
-	for (std::map<double, long>::iterator it = price_qty.begin(); it != price_qty.end(); it++) {
-		agg_offer_stack.push_back(Order(it->first, it->second, OFFER));
+void BondMarketDataConnector::SubscribeIncremental() {
+
+	//Only services taking deltas can be fed incrementally
+	if (delta_sink == NULL) {
+		Subscribe();
+		return;
 	}
 
-	return OrderBook<Bond>(ob_vec[index].GetProduct(), agg_bid_stack, agg_offer_stack);
+	//After Recover only the lines following the snapshot are replayed
+	MarketDataTextReader input_file("marketdata.txt", sequence, offset);
+	StringView product_id;
+	vector<Order> bid_stack, offer_stack;
+
+	BeginSource(input_file.Data(), input_file.Size(), 0, input_file.Line(), input_file.Offset());
+
+	//Deltas are handed to the service a batch at a time, an update may straddle two batches
+	const size_t batch_size = 1024;
+	vector<LevelDelta> batch;
+	batch.reserve(batch_size + 4 * BOOK_RESERVED_LEVELS);
+
+	LevelDelta end;
+	end.action = UPDATE_END;
+	end.side = BID;
+	end.quantity = 0;
+
+	while (input_file.Next(product_id, bid_stack, offer_stack)) {
+
+		const Bond* product = uni_service->FindBond(product_id);
+
+		if (product == NULL) {
+			continue;
+		}
+
+		int index = product->GetProductIndex();
+
+		normalize_levels(bid_stack, BID);
+		normalize_levels(offer_stack, OFFER);
 
+		if (index >= (int) last_bids.size()) {
+			last_bids.resize(index + 1);
+			last_offers.resize(index + 1);
+		}
+
+		DiffLevels(*product, BID, last_bids[index], bid_stack, batch);
+		DiffLevels(*product, OFFER, last_offers[index], offer_stack, batch);
+
+		end.product = product;
+		end.sequence = input_file.Line();
+		batch.push_back(end);
+
+		//Swap rather than copy, the old vectors are cleared and refilled next line
+		last_bids[index].swap(bid_stack);
+		last_offers[index].swap(offer_stack);
+
+		if (batch.size() >= batch_size) {
+			delta_sink->OnDeltas(&batch[0], batch.size());
+			batch.clear();
+			BeginSource(input_file.Data(), input_file.Size(), 0, input_file.Line(), input_file.Offset());
+		}
+	}
+
+	if (!batch.empty()) {
+		delta_sink->OnDeltas(&batch[0], batch.size());
+	}
+
+	sequence = input_file.Line();
+	offset = input_file.Offset();
+	BeginSource(NULL, 0, 0, 0, 0);
 }
 
+void BondMarketDataConnector::SubscribeVenues() {
 
-BondMarketDataConnector::BondMarketDataConnector(BondMarketDataService* md_service_, BondUniverseService* uni_service_) {
-	md_service = md_service_;
-	uni_service = uni_service_;
+	//Only services consolidating venues can take venue books
+	if (venue_sink == NULL) {
+		Subscribe();
+		return;
+	}
+
+	MarketDataTextReader input_file("marketdata.txt");
+	StringView product_id;
+	vector<Order> bid_stack, offer_stack;
+
+	//Lines seen per product index, picking the venue of the next one
+	vector<int> product_lines;
+
+	while (input_file.Next(product_id, bid_stack, offer_stack)) {
+
+		const Bond* product = uni_service->FindBond(product_id);
+
+		if (product == NULL) {
+			continue;
+		}
+
+		int index = product->GetProductIndex();
+
+		normalize_levels(bid_stack, BID);
+		normalize_levels(offer_stack, OFFER);
+
+		if (index >= (int) product_lines.size()) {
+			product_lines.resize(index + 1, 0);
+		}
+
+		Market venue = (Market) (product_lines[index]++ % VENUE_COUNT);
+
+		venue_sink->OnVenueBook(venue, *product, bid_stack, offer_stack);
+	}
 }
 
-void BondMarketDataConnector::Publish(OrderBook<Bond>& data) {}
+bool BondMarketDataConnector::GetOrigin(unsigned long long message_sequence, SnapshotOrigin& origin) {
 
-void BondMarketDataConnector::Subscribe() {
+	if (source == NULL || message_sequence < batch_sequence) {
+		return false;
+	}
 
-	ifstream input_file;
-	input_file.open("marketdata.txt");
-	string update;
+	unsigned long long messages = message_sequence - batch_sequence;
 
-	vector<Order> bid_stack, offer_stack;
+	//Lines vary in length and are walked from the batch's start, records are a fixed size
+	if (record_size == 0) {
+		origin.offset = skip_lines(source + batch_offset, source + source_size, messages) - source;
+	}
+	else {
+		origin.offset = batch_offset + messages * record_size;
+	}
 
-	string product;
-	double price;
-	long quantity;
+	origin.source_hash = snapshot_source_hash(source, origin.offset);
+	origin.universe_hash = uni_service->IdHash();
+	return true;
+}
 
-	while (getline(input_file, update)) {
+unsigned long long BondMarketDataConnector::Recover(const char* path, const char* source_path) {
 
-		bid_stack.clear();
-		offer_stack.clear();
+	if (snapshot_sink == NULL) {
+		return 0;
+	}
 
-		vector<string> update_split = split(update, ",");
+	BinaryBookReader snapshot(path, BINARY_SNAPSHOT_MAGIC);
 
-		for (int i = 0; i < update_split.size() - 2; i += 3) {
+	if (snapshot.Sequence() == 0) {
+		return 0;
+	}
 
-			//First 3 are product id, mid price, MID
-			if (i == 0) {	
+	//Replaying from the snapshot is only right for the data and universe it was taken from
+	const SnapshotOrigin& origin = snapshot.Origin();
+	MappedFile source_file(source_path);
+	StringView messages = snapshot_messages(source_file.data(), source_file.size());
 
-				product = update_split[i];
+	if (origin.offset > messages.size()
+		|| origin.source_hash != snapshot_source_hash(messages.data(), origin.offset)
+		|| origin.universe_hash != uni_service->IdHash()) {
+		return 0;
+	}
 
-				continue;
-			}
+	vector<OrderBook<Bond> > books;
+	books.reserve(snapshot.Count());
 
-			//Rest are price, quantity, Side
-			TreasuryPrices tp(update_split[i]);
-			price = tp.toDouble();
-			std::sscanf(update_split[i + 1].c_str(), "%d", &quantity);
+	vector<Order> bid_stack, offer_stack;
 
-			if (update_split[i + 2] == "BID") {
-				bid_stack.push_back(Order(price, quantity, BID));
-			}
-			else {
-				offer_stack.push_back(Order(price, quantity, OFFER));
-			}
+	for (size_t r = 0; r < snapshot.Count(); r++) {
+
+		const Bond* product = uni_service->FindBond(snapshot.ProductId(r));
+
+		if (product == NULL) {
+			continue;
 		}
 
-		Bond b = uni_service->GetData(product);
-		OrderBook<Bond> ob(b, bid_stack, offer_stack);
+		int index = product->GetProductIndex();
+
+		unpack_binary_book(snapshot.Record(r), bid_stack, offer_stack);
+
+		//Best price first, as incremental replay applies levels to the restored books
+		normalize_levels(bid_stack, BID);
+		normalize_levels(offer_stack, OFFER);
+
+		books.push_back(OrderBook<Bond>(*product, bid_stack, offer_stack));
+		books.back().SetSequence(snapshot.Sequence());
 
-		md_service->OnMessage(ob);
+		//Incremental replay diffs the first line of each product against the restored levels
+		if (index >= (int) last_bids.size()) {
+			last_bids.resize(index + 1);
+			last_offers.resize(index + 1);
+		}
+
+		last_bids[index] = bid_stack;
+		last_offers[index] = offer_stack;
 	}
+
+	snapshot_sink->OnSnapshot(books.empty() ? NULL : &books[0], books.size(), snapshot.Sequence());
+
+	sequence = snapshot.Sequence();
+	offset = origin.offset;
+	return sequence;
 }
 
 #endif
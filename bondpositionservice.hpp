@@ -7,17 +7,27 @@
 #include "positionservice.hpp"
 #include "bondtradebookingservice.hpp"
 #include "bondriskservice.hpp"
+#include "keyedstore.hpp"
+#include "sharedstate.hpp"
 
-class BondPositionService : public PositionService<Bond>
+template<typename L = DynamicListeners<Position<Bond> > >
+class BasicBondPositionService : public PositionService<Bond>
 {
 private:
 	
-	vector<string> product_vec;
-	vector<Position<Bond> > position_vec;
-	vector<ServiceListener<Position<Bond> >* > listeners;
+	ProductStore<Position<Bond> > position_store;
+	L listeners;
+
+	//Also written with every aggregate position for other processes to read, NULL if not
+	PositionTable* position_table;
 
 public:;
 
+	BasicBondPositionService();
+
+	// ctor wiring the listeners up front, needed for a StaticListeners set
+	BasicBondPositionService(const L& listeners_);
+
 	// Get data on our service given a key
 	Position<Bond> GetData(string);
 
@@ -34,16 +44,23 @@ public:;
 	// Add a trade to the service
 	void AddTrade(const Trade<Bond>&);
 
+	// Publish every aggregate position to table as it is stored, the service's thread being
+	// its one writer
+	void PublishTo(PositionTable* table);
+
 };
 
-class BondTradeBookingServiceListener : public ServiceListener<Trade<Bond> >
+typedef BasicBondPositionService<> BondPositionService;
+
+template<typename S = BondPositionService>
+class BasicBondTradeBookingServiceListener : public ServiceListener<Trade<Bond> >
 {
 private:
-	BondPositionService* position_service;
+	S* position_service;
 
 public:
 
-	BondTradeBookingServiceListener(BondPositionService*);
+	BasicBondTradeBookingServiceListener(S*);
 
 	// Listener callback to process an add event to the Service
 	void ProcessAdd(Trade<Bond>& data);
@@ -56,14 +73,17 @@ public:
 
 };
 
-class BondPositionServiceListener : public ServiceListener<Position<Bond> >
+typedef BasicBondTradeBookingServiceListener<> BondTradeBookingServiceListener;
+
+template<typename S = BondRiskService>
+class BasicBondPositionServiceListener : public ServiceListener<Position<Bond> >
 {
 private:
-	BondRiskService* risk_service;
+	S* risk_service;
 
 public:
 
-	BondPositionServiceListener(BondRiskService*);
+	BasicBondPositionServiceListener(S*);
 
 	// Listener callback to process an add event to the Service
 	void ProcessAdd(Position<Bond>& data);
@@ -76,52 +96,63 @@ public:
 
 };
 
+typedef BasicBondPositionServiceListener<> BondPositionServiceListener;
+
+template<typename L>
+BasicBondPositionService<L>::BasicBondPositionService() {
+	position_table = NULL;
+}
+
+template<typename L>
+BasicBondPositionService<L>::BasicBondPositionService(const L& listeners_) :
+	listeners(listeners_)
+{
+	position_table = NULL;
+}
+
 // Get data on our service given a key
-Position<Bond> BondPositionService::GetData(string product_id) {
-	int index = find(product_vec.begin(), product_vec.end(), product_id) - product_vec.begin();
-	return position_vec[index];
+template<typename L>
+Position<Bond> BasicBondPositionService<L>::GetData(string product_id) {
+	return *position_store.Find(product_id);
 }
 
 // The callback that a Connector should invoke for any new or updated data
-void BondPositionService::OnMessage(Position<Bond>& pos) {
+template<typename L>
+void BasicBondPositionService<L>::OnMessage(Position<Bond>& pos) {
 
-	int index = find(product_vec.begin(), product_vec.end(), pos.GetProduct().GetProductId()) - product_vec.begin();
+	position_store.Put(pos.GetProductIndex(), pos.GetProduct().GetProductId(), pos);
 
-	if (index < product_vec.size()) {
-		product_vec.erase(product_vec.begin() + index);
-		position_vec.erase(position_vec.begin() + index);
+	if (position_table != NULL) {
+		position_table->Publish(pos.GetProductIndex(), pos.GetAggregatePosition());
 	}
 
-	product_vec.push_back(pos.GetProduct().GetProductId());
-	position_vec.push_back(pos);
-
-
-	for (int i = 0; i < listeners.size(); i++) {
-		listeners[i]->ProcessAdd(pos);
-	}
+	listeners.ProcessAdd(pos);
 
 }
 
 // Add a listener to the Service for callbacks on add, remove, and update events
 // for data to the Service.
-void BondPositionService::AddListener(ServiceListener<Position<Bond> >* listener) {
-	listeners.push_back(listener);
+template<typename L>
+void BasicBondPositionService<L>::AddListener(ServiceListener<Position<Bond> >* listener) {
+	listeners.Add(listener);
 }
 
 // Get all listeners on the Service.
-const vector<ServiceListener<Position<Bond> >*>& BondPositionService::GetListeners() const {
-	return listeners;
+template<typename L>
+const vector<ServiceListener<Position<Bond> >*>& BasicBondPositionService<L>::GetListeners() const {
+	return listeners.Get();
 }
 
 // Add a trade to the service
-void BondPositionService::AddTrade(const Trade<Bond>& trade) {
+template<typename L>
+void BasicBondPositionService<L>::AddTrade(const Trade<Bond>& trade) {
 
-	int index = find(product_vec.begin(), product_vec.end(), trade.GetProduct().GetProductId()) - product_vec.begin();
+	Position<Bond>* existing = position_store.Find(trade.GetProductIndex());
 
 	std::string book = trade.GetBook();
 
 	//Product Id does not yet exist, need to start from empty position
-	if (index >= product_vec.size()) {
+	if (existing == NULL) {
 		
 		Position<Bond> p(trade.GetProduct());
 		p.AddQty(book, trade.GetSide() == BUY ? trade.GetQuantity() : -trade.GetQuantity());
@@ -131,7 +162,7 @@ void BondPositionService::AddTrade(const Trade<Bond>& trade) {
 	//Product id exists, position exists
 	else {
 
-		Position<Bond> p = position_vec[index];
+		Position<Bond> p = *existing;
 		p.AddQty(book, trade.GetSide() == BUY ? trade.GetQuantity() : -trade.GetQuantity());
 		OnMessage(p);
 
@@ -139,34 +170,47 @@ void BondPositionService::AddTrade(const Trade<Bond>& trade) {
 
 }
 
-BondTradeBookingServiceListener::BondTradeBookingServiceListener(BondPositionService* pos_service_) {
+template<typename L>
+void BasicBondPositionService<L>::PublishTo(PositionTable* table) {
+	position_table = table;
+}
+
+template<typename S>
+BasicBondTradeBookingServiceListener<S>::BasicBondTradeBookingServiceListener(S* pos_service_) {
 	position_service = pos_service_;
 }
 
 // Listener callback to process an add event to the Service
-void BondTradeBookingServiceListener::ProcessAdd(Trade<Bond>& data) {
+template<typename S>
+void BasicBondTradeBookingServiceListener<S>::ProcessAdd(Trade<Bond>& data) {
 	position_service->AddTrade(data);
 }
 
 // Listener callback to process a remove event to the Service
-void BondTradeBookingServiceListener::ProcessRemove(Trade<Bond>& data) {}
+template<typename S>
+void BasicBondTradeBookingServiceListener<S>::ProcessRemove(Trade<Bond>& data) {}
 
 // Listener callback to process an update event to the Service
-void BondTradeBookingServiceListener::ProcessUpdate(Trade<Bond>& data) {}
+template<typename S>
+void BasicBondTradeBookingServiceListener<S>::ProcessUpdate(Trade<Bond>& data) {}
 
-BondPositionServiceListener::BondPositionServiceListener(BondRiskService* risk_service_) {
+template<typename S>
+BasicBondPositionServiceListener<S>::BasicBondPositionServiceListener(S* risk_service_) {
 	risk_service = risk_service_;
 }
 
 // Listener callback to process an add event to the Service
-void BondPositionServiceListener::ProcessAdd(Position<Bond>& data) {
+template<typename S>
+void BasicBondPositionServiceListener<S>::ProcessAdd(Position<Bond>& data) {
 	risk_service->AddPosition(data);
 }
 
 // Listener callback to process a remove event to the Service
-void BondPositionServiceListener::ProcessRemove(Position<Bond>& data) {}
+template<typename S>
+void BasicBondPositionServiceListener<S>::ProcessRemove(Position<Bond>& data) {}
 
 // Listener callback to process an update event to the Service
-void BondPositionServiceListener::ProcessUpdate(Position<Bond>& data) {}
+template<typename S>
+void BasicBondPositionServiceListener<S>::ProcessUpdate(Position<Bond>& data) {}
 
 #endif
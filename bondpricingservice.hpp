@@ -5,30 +5,38 @@
 #define BOND_PRICING_SERVICE_HPP
 
 #include "soa.hpp"
+#include "keyedstore.hpp"
 #include "products.hpp"
 #include "pricingservice.hpp"
 #include "bonduniverseservice.hpp"
 #include "util.hpp"
+#include "mappedfile.hpp"
+#include "tokenizer.hpp"
+#include "pricetable.hpp"
 
 class BondPricingService : public PricingService<Bond>
 {
 private:
 
-	vector<string> product_vec;
-	vector<Bond> products;
-	vector<double> mids;
-	vector<double> spreads;
-	//vector<Price<Bond> > price_vec;
+	ProductStore<Price<Bond> > price_store;
 	vector<ServiceListener<Price<Bond> >* > listeners;
 
+	//Also written with every price for other threads to read, NULL if not
+	PriceTable* price_table;
+
 public:
 
+	BondPricingService();
+
 	// Get data on our service given a key
 	Price<Bond> GetData(string product_id);
 
 	// The callback that a Connector should invoke for any new or updated data
 	void OnMessage(Price<Bond>& ob);
 
+	// Store a batch of prices, then hand the whole batch to each listener
+	void OnMessageBatch(Price<Bond>* ps, size_t count);
+
 	// Add a listener to the Service for callbacks on add, remove, and update events
 	// for data to the Service.
 	void AddListener(ServiceListener<Price<Bond> >* listener);
@@ -36,6 +44,9 @@ public:
 	// Get all listeners on the Service.
 	const vector<ServiceListener<Price<Bond> >* >& GetListeners() const;
 
+	// Publish every price to table as it is stored, the service's thread being its one writer
+	void PublishTo(PriceTable* table);
+
 };
 
 // Connector subscribing data from marketdata.txt to BondMarketDataService.
@@ -59,36 +70,46 @@ public:
 
 };
 
+BondPricingService::BondPricingService() {
+	price_table = NULL;
+}
+
 // Get data on our service given a key
 Price<Bond> BondPricingService::GetData(string product_id) {
-	int index = find(product_vec.begin(), product_vec.end(), product_id) - product_vec.begin();
-	return Price<Bond>(products[index], mids[index], spreads[index]);
-	//return price_vec[index];
+	return *price_store.Find(product_id);
 }
 
 // The callback that a Connector should invoke for any new or updated data
 void BondPricingService::OnMessage(Price<Bond>& p) {
 
-	int index = find(product_vec.begin(), product_vec.end(), p.GetProduct().GetProductId()) - product_vec.begin();
+	price_store.Put(p.GetProductIndex(), p.GetProduct().GetProductId(), p);
 
-	if (index < product_vec.size()) {
-		product_vec.erase(product_vec.begin() + index);
-		products.erase(products.begin() + index);
-		mids.erase(mids.begin() + index);
-		spreads.erase(spreads.begin() + index);
+	if (price_table != NULL) {
+		price_table->Publish(p.GetProductIndex(), p.GetMid(), p.GetBidOfferSpread());
 	}
 
-	product_vec.push_back(p.GetProduct().GetProductId());
-	products.push_back(p.GetProduct());
-	mids.push_back(p.GetMid());
-	spreads.push_back(p.GetBidOfferSpread());
-	//price_vec.push_back(p);
-
 	for (int i = 0; i < listeners.size(); i++) {
 		listeners[i]->ProcessAdd(p);
 	}
 }
 
+void BondPricingService::OnMessageBatch(Price<Bond>* ps, size_t count) {
+
+	for (size_t i = 0; i < count; i++) {
+		price_store.Put(ps[i].GetProductIndex(), ps[i].GetProduct().GetProductId(), ps[i]);
+	}
+
+	if (price_table != NULL) {
+		for (size_t i = 0; i < count; i++) {
+			price_table->Publish(ps[i].GetProductIndex(), ps[i].GetMid(), ps[i].GetBidOfferSpread());
+		}
+	}
+
+	for (int i = 0; i < listeners.size(); i++) {
+		listeners[i]->ProcessAddBatch(ps, count);
+	}
+}
+
 // Add a listener to the Service for callbacks on add, remove, and update events
 // for data to the Service.
 void BondPricingService::AddListener(ServiceListener<Price<Bond> >* listener) {
@@ -100,6 +121,10 @@ const vector<ServiceListener<Price<Bond> >*>& BondPricingService::GetListeners()
 	return listeners;
 }
 
+void BondPricingService::PublishTo(PriceTable* table) {
+	price_table = table;
+}
+
 BondPricingConnector::BondPricingConnector(BondPricingService* prc_service_, BondUniverseService* uni_service_) {
 	prc_service = prc_service_;
 	uni_service = uni_service_;
@@ -108,24 +133,44 @@ BondPricingConnector::BondPricingConnector(BondPricingService* prc_service_, Bon
 void BondPricingConnector::Publish(Price<Bond>& data) {}
 
 void BondPricingConnector::Subscribe() {
-	ifstream input_file;
-	input_file.open("prices.txt");
-	string update;
 
-	Bond b;
-	double bid;
-	double offer;
+	MappedFile input_file("prices.txt");
+	Tokenizer tokenizer(input_file);
+	vector<StringView> update_split;
+
+	TickPrice bid;
+	TickPrice offer;
 
-	while (getline(input_file, update)) {
+	//Prices are handed to the service a batch at a time
+	const size_t batch_size = 1024;
+	vector<Price<Bond> > batch;
+	batch.reserve(batch_size);
 
-		vector<string> update_split = split(update, ",");
+	while (tokenizer.NextLine(update_split)) {
 
-		b = uni_service->GetData(update_split[0]);
-		bid = TreasuryPrices(update_split[1]).toDouble();
-		offer = TreasuryPrices(update_split[2]).toDouble();
+		if (update_split.size() < 3) {
+			continue;
+		}
+
+		const Bond* b = uni_service->FindBond(update_split[0]);
+
+		if (b == NULL) {
+			continue;
+		}
+
+		bid = TickPrice::fromTicks(parse_ticks(update_split[1]));
+		offer = TickPrice::fromTicks(parse_ticks(update_split[2]));
+
+		batch.push_back(Price<Bond>(*b, (bid + offer) / 2, offer - bid));
+
+		if (batch.size() == batch_size) {
+			prc_service->OnMessageBatch(&batch[0], batch.size());
+			batch.clear();
+		}
+	}
 
-		Price<Bond> p(b, (bid + offer) / 2, offer - bid);
-		prc_service->OnMessage(p);
+	if (!batch.empty()) {
+		prc_service->OnMessageBatch(&batch[0], batch.size());
 	}
 }
 
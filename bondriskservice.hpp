@@ -6,17 +6,23 @@
 
 #include "riskservice.hpp"
 #include "products.hpp"
+#include "keyedstore.hpp"
 
-class BondRiskService : public RiskService<Bond>
+template<typename L = DynamicListeners<PV01<Bond> > >
+class BasicBondRiskService : public RiskService<Bond>
 {
 private:
 	
-	vector<string> product_vec;
-	vector<PV01<Bond> > pv_vec;
-	vector<ServiceListener<PV01<Bond> >* > listeners;
+	ProductStore<PV01<Bond> > pv_store;
+	L listeners;
 
 public:;
 
+	BasicBondRiskService();
+
+	// ctor wiring the listeners up front, needed for a StaticListeners set
+	BasicBondRiskService(const L& listeners_);
+
 	// Get data on our service given a key
 	PV01<Bond> GetData(string);
 
@@ -38,49 +44,54 @@ public:;
 
 };
 
+typedef BasicBondRiskService<> BondRiskService;
+
+template<typename L>
+BasicBondRiskService<L>::BasicBondRiskService() {}
+
+template<typename L>
+BasicBondRiskService<L>::BasicBondRiskService(const L& listeners_) :
+	listeners(listeners_)
+{
+}
+
 // Get data on our service given a key
-PV01<Bond> BondRiskService::GetData(string product_id) {
-	int index = find(product_vec.begin(), product_vec.end(), product_id) - product_vec.begin();
-	return pv_vec[index];
+template<typename L>
+PV01<Bond> BasicBondRiskService<L>::GetData(string product_id) {
+	return *pv_store.Find(product_id);
 }
 
 // The callback that a Connector should invoke for any new or updated data
-void BondRiskService::OnMessage(PV01<Bond>& pv_) {
-
-	int index = find(product_vec.begin(), product_vec.end(), pv_.GetProduct().GetProductId()) - product_vec.begin();
+template<typename L>
+void BasicBondRiskService<L>::OnMessage(PV01<Bond>& pv_) {
 
-	if (index < product_vec.size()) {
-		product_vec.erase(product_vec.begin() + index);
-		pv_vec.erase(pv_vec.begin() + index);
-	}
+	pv_store.Put(pv_.GetProductIndex(), pv_.GetProduct().GetProductId(), pv_);
 
-	product_vec.push_back(pv_.GetProduct().GetProductId());
-	pv_vec.push_back(pv_);
 
-
-	for (int i = 0; i < listeners.size(); i++) {
-		listeners[i]->ProcessAdd(pv_);
-	}
+	listeners.ProcessAdd(pv_);
 
 }
 
 // Add a listener to the Service for callbacks on add, remove, and update events
 // for data to the Service.
-void BondRiskService::AddListener(ServiceListener<PV01<Bond> >* listener) {
-	listeners.push_back(listener);
+template<typename L>
+void BasicBondRiskService<L>::AddListener(ServiceListener<PV01<Bond> >* listener) {
+	listeners.Add(listener);
 }
 
 // Get all listeners on the Service.
-const vector<ServiceListener<PV01<Bond> >*>& BondRiskService::GetListeners() const {
-	return listeners;
+template<typename L>
+const vector<ServiceListener<PV01<Bond> >*>& BasicBondRiskService<L>::GetListeners() const {
+	return listeners.Get();
 }
 
 // Add a position that the service will risk
-void BondRiskService::AddPosition(Position<Bond>& position) {
+template<typename L>
+void BasicBondRiskService<L>::AddPosition(Position<Bond>& position) {
 
-	int index = find(product_vec.begin(), product_vec.end(), position.GetProduct().GetProductId()) - product_vec.begin();
+	PV01<Bond>* existing = pv_store.Find(position.GetProductIndex());
 
-	if (index >= product_vec.size()) {
+	if (existing == NULL) {
 
 		PV01<Bond> pv(position.GetProduct(), 0.025, position.GetAggregatePosition());
 		OnMessage(pv);
@@ -88,7 +99,7 @@ void BondRiskService::AddPosition(Position<Bond>& position) {
 	}
 	else {
 
-		PV01<Bond> pv = pv_vec[index];
+		PV01<Bond> pv = *existing;
 		pv.SetQuantity(position.GetAggregatePosition());
 		OnMessage(pv);
 
@@ -97,20 +108,20 @@ void BondRiskService::AddPosition(Position<Bond>& position) {
 }
 
 // Get the bucketed risk for the bucket sector
-const PV01< BucketedSector<Bond> > BondRiskService::GetBucketedRisk(const BucketedSector<Bond>& sector) const {
+template<typename L>
+const PV01< BucketedSector<Bond> > BasicBondRiskService<L>::GetBucketedRisk(const BucketedSector<Bond>& sector) const {
 
 
 
 	double pv = 0;
 	long qty = 0;
 
-	std::vector<Bond> products = sector.GetProducts();
-	int index;
+	const std::vector<Bond>& products = sector.GetProducts();
 
 	for (int i = 0; i < products.size(); i++) {
-		int index = find(product_vec.begin(), product_vec.end(), products[i].GetProductId()) - product_vec.begin();
-		pv += pv_vec[index].GetPV01() * pv_vec[index].GetQuantity();
-		qty += pv_vec[index].GetQuantity();
+		const PV01<Bond>& product_pv = *pv_store.Find(products[i].GetProductId());
+		pv += product_pv.GetPV01() * product_pv.GetQuantity();
+		qty += product_pv.GetQuantity();
 	
 	}
 
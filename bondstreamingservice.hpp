@@ -4,8 +4,10 @@
 #ifndef BOND_STREAMING_SERVICE_HPP
 #define BOND_STREAMING_SERVICE_HPP
 
+#include <sstream>
 #include "streamingservice.hpp"
 #include "bondalgostreamingservice.hpp"
+#include "keyedstore.hpp"
 
  //Forward declaration for use in BondExecutionService
 class BondStreamingConnector;
@@ -14,8 +16,7 @@ class BondStreamingService : public StreamingService<Bond>
 {
 private:
 	
-	vector<string> product_vec;
-	vector<PriceStream<Bond> > stream_vec;
+	ProductStore<PriceStream<Bond> > stream_store;
 	vector<ServiceListener<PriceStream<Bond> >* > listeners;
 	BondStreamingConnector* stream_connector;
 
@@ -80,7 +81,7 @@ public:
 
 	void Subscribe();
 
-	setBondStreamingService(BondStreamingService*);
+	void setBondStreamingService(BondStreamingService*);
 
 };
 
@@ -90,22 +91,13 @@ BondStreamingService::BondStreamingService(BondStreamingConnector* stream_connec
 
 // Get data on our service given a key
 PriceStream<Bond> BondStreamingService::GetData(string product_id) {
-	int index = find(product_vec.begin(), product_vec.end(), product_id) - product_vec.begin();
-	return stream_vec[index];
+	return *stream_store.Find(product_id);
 }
 
 // The callback that a Connector should invoke for any new or updated data
 void BondStreamingService::OnMessage(PriceStream <Bond>& stream) {
 	
-	int index = find(product_vec.begin(), product_vec.end(), stream.GetProduct().GetProductId()) - product_vec.begin();
-
-	if (index < product_vec.size()) {
-		product_vec.erase(product_vec.begin() + index);
-		stream_vec.erase(stream_vec.begin() + index);
-	}
-
-	product_vec.push_back(stream.GetProduct().GetProductId());
-	stream_vec.push_back(stream);
+	stream_store.Put(stream.GetProductIndex(), stream.GetProduct().GetProductId(), stream);
 
 	for (int i = 0; i < listeners.size(); i++) {
 		listeners[i]->ProcessAdd(stream);
@@ -155,16 +147,21 @@ BondStreamingConnector::BondStreamingConnector(BondStreamingService* stream_serv
 // Publish data to the Connector
 void BondStreamingConnector::Publish(PriceStream<Bond>& ps) {
 
-	std::cout << "Bond: " << ps.GetProduct().GetProductId() << ", ";
-	std::cout << "Bid: " << ps.GetBidOrder().GetPrice() << ", ";
-	std::cout << "Bid Quantity: " << ps.GetBidOrder().GetVisibleQuantity() + ps.GetBidOrder().GetHiddenQuantity() << ", ";
-	std::cout << "Offer: " << ps.GetOfferOrder().GetPrice() << ", ";
-	std::cout << "Offer Quantity: " << ps.GetOfferOrder().GetVisibleQuantity() + ps.GetOfferOrder().GetHiddenQuantity() << std::endl;
+	//Written with a single call so the line cannot interleave with other threads' output
+	std::ostringstream out;
+
+	out << "Bond: " << ps.GetProduct().GetProductId() << ", ";
+	out << "Bid: " << ps.GetBidOrder().GetPrice() << ", ";
+	out << "Bid Quantity: " << ps.GetBidOrder().GetVisibleQuantity() + ps.GetBidOrder().GetHiddenQuantity() << ", ";
+	out << "Offer: " << ps.GetOfferOrder().GetPrice() << ", ";
+	out << "Offer Quantity: " << ps.GetOfferOrder().GetVisibleQuantity() + ps.GetOfferOrder().GetHiddenQuantity() << std::endl;
+
+	std::cout << out.str() << std::flush;
 }
 
 void BondStreamingConnector::Subscribe() {}
 
-BondStreamingConnector::setBondStreamingService(BondStreamingService* stream_service_) {
+void BondStreamingConnector::setBondStreamingService(BondStreamingService* stream_service_) {
 	stream_service = stream_service_;
 }
 
@@ -7,18 +7,26 @@
 #include "treasuryprices.hpp"
 #include "tradebookingservice.hpp"
 #include "bonduniverseservice.hpp"
+#include "keyedstore.hpp"
 #include "util.hpp"
+#include "mappedfile.hpp"
+#include "tokenizer.hpp"
 
-class BondTradeBookingService : public TradeBookingService<Bond>
+template<typename L = DynamicListeners<Trade<Bond> > >
+class BasicBondTradeBookingService : public TradeBookingService<Bond>
 {
 private:
 
-	vector<string> product_vec;
-	vector<Trade<Bond> > trade_vec;
-	vector<ServiceListener<Trade<Bond> >* > listeners;
+	ProductStore<Trade<Bond> > trade_store;
+	L listeners;
 
 public:
 
+	BasicBondTradeBookingService();
+
+	// ctor wiring the listeners up front, needed for a StaticListeners set
+	BasicBondTradeBookingService(const L& listeners_);
+
 	// Get data on our service given a key
 	Trade<Bond> GetData(string product_id);
 
@@ -37,18 +45,20 @@ public:
 
 };
 
+typedef BasicBondTradeBookingService<> BondTradeBookingService;
+
 // Connector subscribing data from marketdata.txt to BondMarketDataService.
 class BondTradeBookingConnector : public Connector<Trade<Bond> >
 {
 
 private:
 
-	BondTradeBookingService* book_trade_service;
+	Service<string, Trade<Bond> >* book_trade_service;
 	BondUniverseService* uni_service;
 
 public:
 
-	BondTradeBookingConnector(BondTradeBookingService*, BondUniverseService*);
+	BondTradeBookingConnector(Service<string, Trade<Bond> >*, BondUniverseService*);
 
 	// Publish data to the Connector
 	void Publish(Trade<Bond>&);
@@ -58,47 +68,50 @@ public:
 
 };
 
+template<typename L>
+BasicBondTradeBookingService<L>::BasicBondTradeBookingService() {}
+
+template<typename L>
+BasicBondTradeBookingService<L>::BasicBondTradeBookingService(const L& listeners_) :
+	listeners(listeners_)
+{
+}
+
 // Get data on our service given a key
-Trade<Bond> BondTradeBookingService::GetData(string product_id) {
-	int index = find(product_vec.begin(), product_vec.end(), product_id) - product_vec.begin();
-	return trade_vec[index];
+template<typename L>
+Trade<Bond> BasicBondTradeBookingService<L>::GetData(string product_id) {
+	return *trade_store.Find(product_id);
 }
 
 // The callback that a Connector should invoke for any new or updated data
-void BondTradeBookingService::OnMessage(Trade<Bond>& p) {
+template<typename L>
+void BasicBondTradeBookingService<L>::OnMessage(Trade<Bond>& p) {
 	BookTrade(p);
 }
 
 // Add a listener to the Service for callbacks on add, remove, and update events
 // for data to the Service.
-void BondTradeBookingService::AddListener(ServiceListener<Trade<Bond> >* listener) {
-	listeners.push_back(listener);
+template<typename L>
+void BasicBondTradeBookingService<L>::AddListener(ServiceListener<Trade<Bond> >* listener) {
+	listeners.Add(listener);
 }
 
 // Get all listeners on the Service.
-const vector<ServiceListener<Trade<Bond> >*>& BondTradeBookingService::GetListeners() const {
-	return listeners;
+template<typename L>
+const vector<ServiceListener<Trade<Bond> >*>& BasicBondTradeBookingService<L>::GetListeners() const {
+	return listeners.Get();
 }
 
 // Book the trade
-void BondTradeBookingService::BookTrade(Trade<Bond>& trade) {
+template<typename L>
+void BasicBondTradeBookingService<L>::BookTrade(Trade<Bond>& trade) {
 
-	int index = find(product_vec.begin(), product_vec.end(), trade.GetProduct().GetProductId()) - product_vec.begin();
+	trade_store.Put(trade.GetProductIndex(), trade.GetProduct().GetProductId(), trade);
 
-	if (index < product_vec.size()) {
-		product_vec.erase(product_vec.begin() + index);
-		trade_vec.erase(trade_vec.begin() + index);
-	}
-
-	product_vec.push_back(trade.GetProduct().GetProductId());
-	trade_vec.push_back(trade);
-
-	for (int i = 0; i < listeners.size(); i++) {
-		listeners[i]->ProcessAdd(trade);
-	}
+	listeners.ProcessAdd(trade);
 }
 
-BondTradeBookingConnector::BondTradeBookingConnector(BondTradeBookingService* book_trade_service_, BondUniverseService* uni_service_) {
+BondTradeBookingConnector::BondTradeBookingConnector(Service<string, Trade<Bond> >* book_trade_service_, BondUniverseService* uni_service_) {
 	book_trade_service = book_trade_service_;
 	uni_service = uni_service_;
 }
@@ -106,23 +119,30 @@ BondTradeBookingConnector::BondTradeBookingConnector(BondTradeBookingService* bo
 void BondTradeBookingConnector::Publish(Trade<Bond>& data) {}
 
 void BondTradeBookingConnector::Subscribe() {
-	ifstream input_file;
-	input_file.open("trades.txt");
-	string update;
 
-	Bond b;
+	MappedFile input_file("trades.txt");
+	Tokenizer tokenizer(input_file);
+	vector<StringView> update_split;
+
 	TreasuryPrices price;
 	long quantity;
 
-	while (getline(input_file, update)) {
+	while (tokenizer.NextLine(update_split)) {
+
+		if (update_split.size() < 6) {
+			continue;
+		}
+
+		const Bond* b = uni_service->FindBond(update_split[0]);
 
-		vector<string> update_split = split(update, ",");
+		if (b == NULL) {
+			continue;
+		}
 
-		b = uni_service->GetData(update_split[0]);
 		price = TreasuryPrices(update_split[2]);
-		std::sscanf(update_split[4].c_str(), "%d", &quantity);
+		quantity = parse_long(update_split[4]);
 
-		Trade<Bond> t(b, update_split[1], price.toDouble(), update_split[3], quantity, update_split[5] == "BUY" ? BUY : SELL);
+		Trade<Bond> t(*b, update_split[1].str(), TickPrice::fromTicks(price.toTicks()), update_split[3].str(), quantity, update_split[5] == "BUY" ? BUY : SELL);
 		book_trade_service->OnMessage(t);
 
 	}
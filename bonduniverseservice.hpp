@@ -6,15 +6,41 @@
 
 #include <iostream>
 #include <algorithm>
+#include <deque>
 #include "products.hpp"
 #include "soa.hpp"
-
+#include "keyedstore.hpp"
+#include "mappedfile.hpp"
+#include "tokenizer.hpp"
+#include "util.hpp"
+
+//Registry of tradeable bonds. Each bond is assigned a dense product index on registration,
+//which the data types carry so downstream services can index arrays instead of hashing ids.
+//The data types point at the bonds held here rather than copying them, so a registered bond
+//never moves for the life of the service.
 class BondUniverseService : public Service<string, Bond> {
 
 public:
 
+	BondUniverseService();
+
 	Bond GetData(string);
 
+	// Get a bond by its dense product index
+	const Bond& GetBond(int index) const;
+
+	// Get a bond by product id without copying it, NULL if it is not in the universe
+	const Bond* FindBond(StringView id) const;
+
+	// Dense product index of a product id, -1 if it is not in the universe
+	int GetProductIndex(StringView id) const;
+
+	// Number of registered bonds, product indices run from 0 to Size() - 1
+	int Size() const;
+
+	// Hash of every product id in index order, changing whenever a bond is registered
+	unsigned long long IdHash() const;
+
 	vector<Bond> GetUniverse();
 
 	void OnMessage(Bond& bond);
@@ -25,27 +51,129 @@ public:
 
 private:
 
-	std::vector<string> id_vec;
-	std::vector<Bond> bond_universe;
+	//Indexed by product index, deque so registering a bond never moves the others
+	deque<Bond> bond_universe;
+	vector<ServiceListener<Bond>*> listeners;
+
+	//Product index by id, keyed on views of the ids of the bonds held above so parsed ids
+	//are looked up without copying them
+	KeyedStore<StringView, int> indices;
+
+};
+
+//Loads reference data lines of id,ticker,coupon,maturity, after a header line, into the
+//universe, all ids CUSIPs
+class BondUniverseConnector : public Connector<Bond>
+{
+
+private:
+
+	BondUniverseService* uni_service;
+
+public:
+
+	BondUniverseConnector(BondUniverseService*);
+
+	// Publish data to the Connector
+	void Publish(Bond&);
+
+	// Subscribe to a reference data file, bonds.txt by default
+	void Subscribe(const char* path = "bonds.txt");
 
 };
 
+BondUniverseService::BondUniverseService() {}
+
 Bond BondUniverseService::GetData(string id) {
-	int index = find(id_vec.begin(), id_vec.end(), id) - id_vec.begin();
+	const Bond* bond = FindBond(id);
+	return bond == NULL ? Bond() : *bond;
+}
+
+const Bond& BondUniverseService::GetBond(int index) const {
 	return bond_universe[index];
 }
 
+const Bond* BondUniverseService::FindBond(StringView id) const {
+	int index = GetProductIndex(id);
+	return index == -1 ? NULL : &bond_universe[index];
+}
+
+int BondUniverseService::GetProductIndex(StringView id) const {
+	const int* index = indices.Find(id);
+	return index == NULL ? -1 : *index;
+}
+
+int BondUniverseService::Size() const {
+	return (int) bond_universe.size();
+}
+
+unsigned long long BondUniverseService::IdHash() const {
+
+	KeyHash<string> hash;
+	unsigned long long h = bond_universe.size();
+
+	for (size_t i = 0; i < bond_universe.size(); i++) {
+		h = h * 1099511628211ULL ^ hash(bond_universe[i].GetProductId());
+	}
+
+	return h;
+}
+
 vector<Bond> BondUniverseService::GetUniverse() {
-	return bond_universe;
+	return vector<Bond>(bond_universe.begin(), bond_universe.end());
 }
 
 void BondUniverseService::OnMessage(Bond& bond) {
-	id_vec.push_back(bond.GetProductId());
+
+	int existing = GetProductIndex(bond.GetProductId());
+
+	//Re-registering a bond keeps its index and updates it in place. The key views the id
+	//being replaced, so it is dropped first and stored again over the new copy.
+	if (existing != -1) {
+		indices.Erase(bond.GetProductId());
+		bond.SetProductIndex(existing);
+		bond_universe[existing] = bond;
+		indices.Put(bond_universe[existing].GetProductId(), existing);
+		return;
+	}
+
+	bond.SetProductIndex(Size());
 	bond_universe.push_back(bond);
+	indices.Put(bond_universe.back().GetProductId(), Size() - 1);
 }
 
 void BondUniverseService::AddListener(ServiceListener<Bond >* listener) {}
 
-const vector<ServiceListener<Bond>*>& BondUniverseService::GetListeners() const {}
+const vector<ServiceListener<Bond>*>& BondUniverseService::GetListeners() const {
+	return listeners;
+}
+
+BondUniverseConnector::BondUniverseConnector(BondUniverseService* uni_service_) {
+	uni_service = uni_service_;
+}
+
+void BondUniverseConnector::Publish(Bond&) {}
+
+void BondUniverseConnector::Subscribe(const char* path) {
+
+	MappedFile input_file(path);
+	Tokenizer tokenizer(input_file);
+	vector<StringView> update_split;
+
+	//Header
+	tokenizer.NextLine(update_split);
+
+	while (tokenizer.NextLine(update_split)) {
+
+		if (update_split.size() < 4) {
+			continue;
+		}
+
+		float coupon = (float) parse_double(update_split[2]);
+
+		Bond bond(update_split[0].str(), CUSIP, update_split[1].str(), coupon, update_split[3].str());
+		uni_service->OnMessage(bond);
+	}
+}
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,226 @@
+/**
+ * conflatinglistener.hpp
+ * Listener adapter for slow consumers: keeps only the latest value per product and lets
+ * the consumer drain at its own pace instead of receiving every update.
+ *
+ */
+#ifndef CONFLATING_LISTENER_HPP
+#define CONFLATING_LISTENER_HPP
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "soa.hpp"
+#include "pipelinestage.hpp"
+
+using namespace std;
+
+//Conflation key of a value, the dense product index by default
+template<typename V>
+struct ProductKey
+{
+	int operator()(const V& data) const {
+		return data.GetProductIndex();
+	}
+};
+
+//Kind of the event pending for a key, NOT_PENDING once drained
+enum ConflatedEvent { NOT_PENDING, PENDING_ADD, PENDING_UPDATE, PENDING_REMOVE };
+
+/**
+ * Listener that overwrites the pending value of a product on every event rather than
+ * queueing it. The latest event kind is kept with the value, except that an update to a
+ * pending add stays an add, since the consumer has not seen the add yet. Drain delivers the
+ * pending values, in the order their products first became pending, to the matching
+ * callback of the wrapped listener, runs of adds as one batch.
+ * Drain can be called by the owner, or Start runs a thread that drains continuously so the
+ * notifying Service never waits on the consumer. Either way only one thread may drain.
+ * Type V must be copy constructible and assignable, K maps a value to a non-negative key.
+ */
+template<typename V, typename K = ProductKey<V> >
+class ConflatingListener : public ServiceListener<V>, public PipelineStage
+{
+
+private:
+
+	ServiceListener<V>* target;
+	K key;
+
+	//Latest value and event per key, order lists the keys not yet drained
+	mutex lock;
+	vector<V> latest;
+	vector<char> pending;
+	vector<int> order;
+
+	//Drain side copies, reused between drains
+	vector<V> batch;
+	vector<char> batch_events;
+
+	// Make data the pending value of its key with event
+	void Conflate(V& data, ConflatedEvent event);
+
+	atomic<bool> stopping;
+	thread drainer;
+
+	// Drainer thread body
+	void Run();
+
+public:
+
+	ConflatingListener(ServiceListener<V>* target_);
+
+	~ConflatingListener();
+
+	void ProcessAdd(V& data);
+
+	void ProcessRemove(V& data);
+
+	void ProcessUpdate(V& data);
+
+	// Deliver every pending value to the wrapped listener, returns how many were delivered
+	size_t Drain();
+
+	// Drain continuously on a dedicated thread, optionally pinned to cpu
+	void Start(int cpu = -1);
+
+	// Stop the drainer thread if running and deliver what is still pending
+	void Stop();
+
+};
+
+template<typename V, typename K>
+ConflatingListener<V, K>::ConflatingListener(ServiceListener<V>* target_) : target(target_), stopping(false) {}
+
+template<typename V, typename K>
+ConflatingListener<V, K>::~ConflatingListener() {
+	Stop();
+}
+
+template<typename V, typename K>
+void ConflatingListener<V, K>::Conflate(V& data, ConflatedEvent event) {
+
+	int k = key(data);
+
+	lock_guard<mutex> guard(lock);
+
+	if (k >= (int) latest.size()) {
+		latest.resize(k + 1, data);
+		pending.resize(k + 1, NOT_PENDING);
+	}
+
+	latest[k] = data;
+
+	if (pending[k] == NOT_PENDING) {
+		order.push_back(k);
+	}
+	else if (pending[k] == PENDING_ADD && event == PENDING_UPDATE) {
+		return;
+	}
+
+	pending[k] = event;
+}
+
+template<typename V, typename K>
+void ConflatingListener<V, K>::ProcessAdd(V& data) {
+	Conflate(data, PENDING_ADD);
+}
+
+template<typename V, typename K>
+void ConflatingListener<V, K>::ProcessRemove(V& data) {
+	Conflate(data, PENDING_REMOVE);
+}
+
+template<typename V, typename K>
+void ConflatingListener<V, K>::ProcessUpdate(V& data) {
+	Conflate(data, PENDING_UPDATE);
+}
+
+template<typename V, typename K>
+size_t ConflatingListener<V, K>::Drain() {
+
+	batch.clear();
+	batch_events.clear();
+
+	{
+		lock_guard<mutex> guard(lock);
+
+		for (size_t i = 0; i < order.size(); i++) {
+			batch.push_back(latest[order[i]]);
+			batch_events.push_back(pending[order[i]]);
+			pending[order[i]] = NOT_PENDING;
+		}
+
+		order.clear();
+	}
+
+	//Delivered outside the lock so producers are never blocked behind the consumer
+	size_t i = 0;
+
+	while (i < batch.size()) {
+
+		if (batch_events[i] == PENDING_ADD) {
+
+			size_t run = i + 1;
+			while (run < batch.size() && batch_events[run] == PENDING_ADD) {
+				run++;
+			}
+
+			target->ProcessAddBatch(&batch[i], run - i);
+			i = run;
+		}
+		else {
+
+			if (batch_events[i] == PENDING_UPDATE) {
+				target->ProcessUpdate(batch[i]);
+			}
+			else {
+				target->ProcessRemove(batch[i]);
+			}
+
+			i++;
+		}
+	}
+
+	return batch.size();
+}
+
+template<typename V, typename K>
+void ConflatingListener<V, K>::Run() {
+
+	while (true) {
+
+		//Check before draining, so the final drain sees everything published before Stop
+		bool last = stopping.load(memory_order_acquire);
+
+		if (Drain() == 0) {
+			if (last) {
+				return;
+			}
+			this_thread::yield();
+		}
+	}
+}
+
+template<typename V, typename K>
+void ConflatingListener<V, K>::Start(int cpu) {
+
+	if (!drainer.joinable()) {
+		drainer = thread(&ConflatingListener<V, K>::Run, this);
+		PinThread(drainer, cpu);
+	}
+}
+
+template<typename V, typename K>
+void ConflatingListener<V, K>::Stop() {
+
+	if (drainer.joinable()) {
+		stopping.store(true, memory_order_release);
+		drainer.join();
+	}
+	else {
+		Drain();
+	}
+}
+
+#endif
@@ -0,0 +1,189 @@
+/**
+ * consolidatedbook.hpp
+ * Books of one product on each venue merged into a single book, with the quantity every
+ * venue shows at each consolidated price.
+ *
+ */
+#ifndef CONSOLIDATED_BOOK_HPP
+#define CONSOLIDATED_BOOK_HPP
+
+#include <vector>
+#include "marketdataservice.hpp"
+#include "executionservice.hpp"
+
+using namespace std;
+
+//Venues of the Market enum, which indexes them
+const int VENUE_COUNT = 3;
+
+//One price of the consolidated book, the total and what each venue shows of it
+struct ConsolidatedLevel
+{
+	TickPrice price;
+	long quantity;
+	long venue_quantities[VENUE_COUNT];
+
+	// Venue showing the most at this price, the first in Market order on a tie
+	Market BestVenue() const;
+};
+
+/**
+ * Consolidated book of one product across venues. Each venue update changes only the
+ * consolidated levels at the prices it touches, and applies the same changes through
+ * ApplyLevel to the merged OrderBook the caller keeps, so the merged book is never rebuilt
+ * or copied and readers get the consolidated top and its venues without rescanning every
+ * venue's depth.
+ * Type T is the product type.
+ */
+template<typename T>
+class ConsolidatedBook
+{
+private:
+
+	//Per side, BID then OFFER, best price first
+	vector<ConsolidatedLevel> levels[2];
+
+	// Set what venue shows at price on side, 0 taking it off
+	void SetVenueQuantity(Market venue, PricingSide side, TickPrice price, long quantity, OrderBook<T>& merged);
+
+	// Replace what venue shows on side with stack
+	void UpdateVenueSide(Market venue, PricingSide side, const vector<Order>& stack, OrderBook<T>& merged);
+
+public:
+
+	ConsolidatedBook(size_t reserved_levels = 16);
+
+	// Replace the book of venue, stacks in any order with at most one order per price. merged
+	// must hold the consolidated levels so far, starting empty, and is kept in step.
+	void UpdateVenue(Market venue, const vector<Order>& bid_stack, const vector<Order>& offer_stack, OrderBook<T>& merged);
+
+	// Apply one level change of venue's book, keeping merged in step like UpdateVenue
+	void ApplyLevel(Market venue, PricingSide side, LevelAction action, TickPrice price, long quantity, OrderBook<T>& merged);
+
+	// Number of consolidated prices on a side
+	size_t Levels(PricingSide side) const;
+
+	// Get consolidated level i of a side, best price first
+	const ConsolidatedLevel& GetLevel(PricingSide side, size_t i) const;
+
+};
+
+Market ConsolidatedLevel::BestVenue() const {
+
+	int best = 0;
+
+	for (int v = 1; v < VENUE_COUNT; v++) {
+		if (venue_quantities[v] > venue_quantities[best]) {
+			best = v;
+		}
+	}
+
+	return (Market) best;
+}
+
+template<typename T>
+ConsolidatedBook<T>::ConsolidatedBook(size_t reserved_levels) {
+	levels[0].reserve(reserved_levels);
+	levels[1].reserve(reserved_levels);
+}
+
+template<typename T>
+void ConsolidatedBook<T>::SetVenueQuantity(Market venue, PricingSide side, TickPrice price, long quantity, OrderBook<T>& merged) {
+
+	vector<ConsolidatedLevel>& side_levels = levels[side == BID ? 0 : 1];
+
+	//Books are shallow, a scan from the best price finds the level
+	size_t i = 0;
+	while (i < side_levels.size() && (side == BID ? side_levels[i].price > price : side_levels[i].price < price)) {
+		i++;
+	}
+
+	if (i < side_levels.size() && side_levels[i].price == price) {
+
+		ConsolidatedLevel& level = side_levels[i];
+		long change = quantity - level.venue_quantities[venue];
+
+		if (change == 0) {
+			return;
+		}
+
+		level.venue_quantities[venue] = quantity;
+		level.quantity += change;
+
+		if (level.quantity == 0) {
+			side_levels.erase(side_levels.begin() + i);
+			merged.ApplyLevel(side, LEVEL_DELETE, price, 0);
+		}
+		else {
+			merged.ApplyLevel(side, LEVEL_UPDATE, price, level.quantity);
+		}
+	}
+	else if (quantity != 0) {
+
+		ConsolidatedLevel level;
+		level.price = price;
+		level.quantity = quantity;
+		for (int v = 0; v < VENUE_COUNT; v++) {
+			level.venue_quantities[v] = 0;
+		}
+		level.venue_quantities[venue] = quantity;
+
+		side_levels.insert(side_levels.begin() + i, level);
+		merged.ApplyLevel(side, LEVEL_INSERT, price, quantity);
+	}
+}
+
+template<typename T>
+void ConsolidatedBook<T>::UpdateVenueSide(Market venue, PricingSide side, const vector<Order>& stack, OrderBook<T>& merged) {
+
+	vector<ConsolidatedLevel>& side_levels = levels[side == BID ? 0 : 1];
+
+	//Take off the venue's prices missing from stack, backwards as levels may be erased
+	for (size_t i = side_levels.size(); i-- > 0; ) {
+
+		if (side_levels[i].venue_quantities[venue] == 0) {
+			continue;
+		}
+
+		bool kept = false;
+		for (size_t k = 0; k < stack.size() && !kept; k++) {
+			kept = stack[k].GetPrice() == side_levels[i].price;
+		}
+
+		if (!kept) {
+			SetVenueQuantity(venue, side, side_levels[i].price, 0, merged);
+		}
+	}
+
+	for (size_t k = 0; k < stack.size(); k++) {
+		SetVenueQuantity(venue, side, stack[k].GetPrice(), stack[k].GetQuantity(), merged);
+	}
+}
+
+template<typename T>
+void ConsolidatedBook<T>::UpdateVenue(Market venue, const vector<Order>& bid_stack, const vector<Order>& offer_stack, OrderBook<T>& merged) {
+	UpdateVenueSide(venue, BID, bid_stack, merged);
+	UpdateVenueSide(venue, OFFER, offer_stack, merged);
+}
+
+template<typename T>
+void ConsolidatedBook<T>::ApplyLevel(Market venue, PricingSide side, LevelAction action, TickPrice price, long quantity, OrderBook<T>& merged) {
+
+	if (action == UPDATE_END) {
+		return;
+	}
+
+	SetVenueQuantity(venue, side, price, action == LEVEL_DELETE ? 0 : quantity, merged);
+}
+
+template<typename T>
+size_t ConsolidatedBook<T>::Levels(PricingSide side) const {
+	return levels[side == BID ? 0 : 1].size();
+}
+
+template<typename T>
+const ConsolidatedLevel& ConsolidatedBook<T>::GetLevel(PricingSide side, size_t i) const {
+	return levels[side == BID ? 0 : 1][i];
+}
+
+#endif
@@ -9,20 +9,42 @@
 #include <fstream>
 #include <vector>
 #include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <string>
+#include <thread>
+#include <algorithm>
 #include "products.hpp"
 #include "treasuryprices.hpp"
 #include "tradebookingservice.hpp"
+#include "outputbuffer.hpp"
+#include "generatorconfig.hpp"
 
 class BondGenerator {
 private:
 	//Discrete half-spread sizes
 	std::vector<TreasuryPrices> halfspread_sizes;
 	std::vector<Bond> bonds;
-	TreasuryPrices tick;
+	//Threads rendering market data, prices and trades, and lines rendered across all bonds
+	//before a chunk is written out
+	int n_threads;
+	int chunk_lines;
+
+	//Seeded random walks in place of the fixed oscillation when constructed with a config
+	bool random_walk;
+	GeneratorConfig config;
+
+	// Render n_updates lines per bond from walks into path, a chunk at a time
+	template<typename W>
+	void generate(const char*, const int, std::vector<W>&);
 
 public:
 
-	BondGenerator(const std::vector<Bond>, const std::vector<TreasuryPrices>);
+	BondGenerator(const std::vector<Bond>, const std::vector<TreasuryPrices>, const int n_threads_ = 1, const int chunk_lines_ = 1 << 17);
+
+	// Generator of seeded random walks, reproducible from config.seed
+	BondGenerator(const std::vector<Bond>, const std::vector<TreasuryPrices>, const GeneratorConfig&, const int n_threads_ = 1, const int chunk_lines_ = 1 << 17);
 
 	void generateInquiries(const int);
 
@@ -33,239 +55,751 @@ public:
 	void generateTrades(const int);
 };
 
-BondGenerator::BondGenerator(const std::vector<Bond> bonds_, const std::vector<TreasuryPrices> hs) {
+// Write a reference data file of n_bonds synthetic treasuries as id,ticker,coupon,maturity,
+// the format BondUniverseConnector loads. Ids are distinct CUSIPs with valid check digits.
+void generate_reference_data(const char*, const int, unsigned long long = 1);
+
+BondGenerator::BondGenerator(const std::vector<Bond> bonds_, const std::vector<TreasuryPrices> hs, const int n_threads_, const int chunk_lines_) {
 	halfspread_sizes = hs;
-	tick = TreasuryPrices(0, 0, 1);
 	bonds = bonds_;
+	n_threads = n_threads_;
+	chunk_lines = chunk_lines_;
+	random_walk = false;
 }
 
-void BondGenerator::generateInquiries(const int n_inquiries) {
+BondGenerator::BondGenerator(const std::vector<Bond> bonds_, const std::vector<TreasuryPrices> hs, const GeneratorConfig& config_, const int n_threads_, const int chunk_lines_) :
+	config(config_)
+{
+	halfspread_sizes = hs;
+	bonds = bonds_;
+	n_threads = n_threads_;
+	chunk_lines = chunk_lines_;
+	random_walk = true;
+}
 
-	std::ofstream output;
-	output.open("inquiries.txt");
+//Character of a CUSIP value 0-35, digits then letters
+char cusip_char(int v) {
+	return v < 10 ? (char) ('0' + v) : (char) ('A' + v - 10);
+}
 
-	std::vector<Side> trade_side;
+//Modulus 10 double-add-double check digit over the first eight characters
+char cusip_check_digit(const char* id) {
 
-	for (int i = 0; i < bonds.size(); ++i) {
-		trade_side.push_back(BUY);
+	int sum = 0;
+
+	for (int i = 0; i < 8; i++) {
+
+		int v = isdigit(id[i]) ? id[i] - '0' : id[i] - 'A' + 10;
+		if (i % 2 == 1) v *= 2;
+		sum += v / 10 + v % 10;
 	}
 
-	for (int i = 0; i < n_inquiries; i++) {
+	return (char) ('0' + (10 - sum % 10) % 10);
+}
 
-		for (int bond_index = 0; bond_index < bonds.size(); bond_index++) {
+void generate_reference_data(const char* path, const int n_bonds, unsigned long long seed) {
 
-			output << bond_index + bonds.size() * i << "," << bonds[bond_index].GetProductId();
+	std::ofstream output(path, std::ios::binary);
+	OutputBuffer text;
+	Random random(seed);
 
-			if (trade_side[bond_index] == BUY) {
-				output << ",BUY";
-				trade_side[bond_index] = SELL;
-			}
-			else{
-				output << ",SELL";
-				trade_side[bond_index] = BUY;
-			}
+	char id[10];
+	id[9] = 0;
+	char buffer[40];
 
-			//Old way to generate random numbers - biased - but don't have to deal with include<random> and out of date g++ issues
-			//Not allowing 101 to make computation easier
-			output << "," << (1 + std::rand() % 5) * 1000000;
-			output << "," << TreasuryPrices(99 + std::rand() % 2, std::rand() % (32), std::rand() % 8);
-			output << ",RECEIVED" << std::endl;
+	text.Append("id,ticker,coupon,maturity\n");
 
+	//Treasury issuer prefix, then the bond number in base 36, 1.6 million ids
+	for (int b = 0; b < n_bonds; b++) {
+
+		memcpy(id, "9128", 4);
+		for (int k = 0, n = b; k < 4; k++, n /= 36) {
+			id[7 - k] = cusip_char(n % 36);
 		}
+		id[8] = cusip_check_digit(id);
+
+		//Coupons in eighths up to 6%, maturities out to 30 years
+		int coupon_eighths = random.Uniform(1, 48);
+		int year = random.Uniform(2025, 2055), month = random.Uniform(1, 12), day = random.Uniform(1, 28);
 
+		text.Append(id, 9);
+		text.Append(",T,", 3);
+		text.Append(buffer, snprintf(buffer, sizeof(buffer), "%g", coupon_eighths / 8.0));
+		text.Append(buffer, snprintf(buffer, sizeof(buffer), ",%04d%02d%02d\n", year, month, day));
 	}
 
-	output.close();
+	text.WriteTo(output);
+}
+
+/**
+ * Per-bond state of the market data oscillation: the mid walks between 99 and 101 a tick at a
+ * time while the half spread cycles through the discrete sizes.
+ */
+class MarketDataWalk
+{
+private:
+
+	const std::string* product_id;
+	const std::vector<TreasuryPrices>* halfspread_sizes;
+	int book_depth;
+
+	TreasuryPrices midpoint;
+	TreasuryPrices midpoint_increment;
+	int spread_level;
+	int spread_increment_direction;
+
+public:
+
+	MarketDataWalk(const std::string&, const std::vector<TreasuryPrices>&, int);
+
+	// Render the line for update i and step to the next one
+	void Write(OutputBuffer&, int);
+
+};
+
+/**
+ * Per-bond state of the streamed prices: the bid walks down from 99 and back with the spread
+ * cycling, pulled back whenever the offer would pass 101.
+ */
+class PriceWalk
+{
+private:
+
+	const std::string* product_id;
+	const std::vector<TreasuryPrices>* halfspread_sizes;
+
+	TreasuryPrices bid;
+	TreasuryPrices bid_increment;
+	int spread_level;
+	int spread_increment_direction;
+
+public:
+
+	PriceWalk(const std::string&, const std::vector<TreasuryPrices>&);
+
+	void Write(OutputBuffer&, int);
+
+};
+
+/**
+ * Per-bond state of the trades: bid and offer converge and diverge while the side alternates.
+ * Books rotate TRSY1, TRSY2, TRSY3 across every line of the file, so the book of update i is
+ * derived from the bond's position rather than carried from bond to bond.
+ */
+class TradeWalk
+{
+private:
+
+	const std::string* product_id;
+	int bond_index;
+	int n_bonds;
+
+	TreasuryPrices bid;
+	TreasuryPrices offer;
+	TreasuryPrices increment;
+	Side trade_side;
+
+public:
+
+	TradeWalk(const std::string&, int, int);
+
+	void Write(OutputBuffer&, int);
 
+};
+
+MarketDataWalk::MarketDataWalk(const std::string& product_id_, const std::vector<TreasuryPrices>& hs, int book_depth_) {
+	product_id = &product_id_;
+	halfspread_sizes = &hs;
+	book_depth = book_depth_;
+	midpoint = TreasuryPrices(99, 0, 0);
+	midpoint_increment = TreasuryPrices(0, 0, -1);
+	spread_level = 0;
+	spread_increment_direction = -1;
 }
 
+void MarketDataWalk::Write(OutputBuffer& output, int) {
 
-//Generate marketdata.txt
-void BondGenerator::generateMarketData(const int n_updates, const int book_depth = 5) {
+	//Levels step a tick at a time, so they are rendered from tick counts
+	int mid_ticks = midpoint.toTicks();
+	int halfspread_ticks = (*halfspread_sizes)[spread_level].toTicks();
 
+	output.Append(*product_id);
+	output.Append(',');
+	output.AppendTicks(mid_ticks);
+	output.Append(",MID", 4);
 
-	std::ofstream output;
-	output.open("marketdata.txt");
+	for (int j = 0; j < book_depth; j++) {
+
+		output.Append(',');
+		output.AppendTicks(mid_ticks - halfspread_ticks - j);
+		output.Append(',');
+		output.AppendInt((j+1) * 10000000);
+		output.Append(",BID", 4);
+
+		output.Append(',');
+		output.AppendTicks(mid_ticks + halfspread_ticks + j);
+		output.Append(',');
+		output.AppendInt((j+1) * 10000000);
+		output.Append(",OFFER", 6);
+	}
+
+	output.Append('\n');
+
+	//If midpoint is at min or max value switch increment direction
+	if (midpoint.atMin() || midpoint.atMax()) midpoint_increment.negate();
+	midpoint = midpoint + midpoint_increment;
+
+	//If spread size is at min or max level, switch increment direction
+	if (spread_level == 0 || spread_level == (int) halfspread_sizes->size() - 1) spread_increment_direction *= -1;
+	spread_level += spread_increment_direction;
+}
+
+PriceWalk::PriceWalk(const std::string& product_id_, const std::vector<TreasuryPrices>& hs) {
+	product_id = &product_id_;
+	halfspread_sizes = &hs;
+	bid = TreasuryPrices(99, 0, 0);
+	bid_increment = TreasuryPrices(0, 0, -1);
+	spread_level = 0;
+	spread_increment_direction = -1;
+}
+
+void PriceWalk::Write(OutputBuffer& output, int) {
+
+	TreasuryPrices tick(0, 0, 1);
+
+	TreasuryPrices halfspread = (*halfspread_sizes)[spread_level];
+	TreasuryPrices offer = bid + halfspread * 2;
 
-	//Used to oscillate between discrete spread levels
-	std::vector<int> spread_level;
-	std::vector<int> spread_increment_direction;
+	while (offer.gtMax()) {
+		bid = bid - tick;
+		offer = offer - tick;
 
-	//Tracks each bonds midpoint
-	std::vector<TreasuryPrices> midpoints;
+		bid_increment = TreasuryPrices(0, 0, -1);
+	}
+
+	output.Append(*product_id);
+	output.Append(',');
+	output.AppendPrice(bid);
+	output.Append(',');
+	output.AppendPrice(offer);
+	output.Append('\n');
+
+	if (bid.atMin()) bid_increment.negate();
+	bid = bid + bid_increment;
+
+	if (spread_level == 0 || spread_level == (int) halfspread_sizes->size() - 1) spread_increment_direction *= -1;
+	spread_level += spread_increment_direction;
+}
 
-	//Tracks whether to increase or decrease the midpoint
-	//Could be one value since all bonds have the same oscillation pattern
-	std::vector<TreasuryPrices> midpoint_increments;
+TradeWalk::TradeWalk(const std::string& product_id_, int bond_index_, int n_bonds_) {
+	product_id = &product_id_;
+	bond_index = bond_index_;
+	n_bonds = n_bonds_;
+	bid = TreasuryPrices(99, 0, 0);
+	offer = TreasuryPrices(100, 0, 0);
+	increment = TreasuryPrices(0, 0, -1);
+	trade_side = BUY;
+}
+
+void TradeWalk::Write(OutputBuffer& output, int i) {
+
+	static const char* const books[] = { "TRSY1", "TRSY2", "TRSY3" };
+	TreasuryPrices trade_max(100, 0, 0);
 
-	for (int i = 0; i < bonds.size(); ++i) {
-		midpoints.push_back(TreasuryPrices(99, 0, 0));
-		midpoint_increments.push_back(TreasuryPrices(0, 0, -1));
-		spread_level.push_back(0);
-		spread_increment_direction.push_back(-1);
+	if (bid == offer) {
+		increment.negate();
+
+		bid = bid + increment * 2;
+		offer = offer - increment * 2;
 	}
 
-	//Create n_updates for each bond
-	for (int i = 0; i < n_updates; i++) {
+	output.Append(*product_id);
+	output.Append(",TradeID,", 9);
+
+	const char* side_string;
 
-		//Create an update for each bond - each update will be on one line with product id, mid, and book_depth number of levels
-		for (int bond_index = 0; bond_index < bonds.size(); bond_index++) {
+	if (trade_side == BUY) {
+		output.AppendPrice(bid);
+		trade_side = SELL;
+		side_string = ",BUY\n";
+	}
+	else {
+		output.AppendPrice(offer);
+		trade_side = BUY;
+		side_string = ",SELL\n";
+	}
 
-			output << bonds[bond_index].GetProductId() << "," << midpoints[bond_index] << ",MID";
+	output.Append(',');
+	output.Append(books[((long) i * n_bonds + bond_index) % 3], 5);
+	output.Append(',');
+	output.AppendInt(1000000 * (1 + i % 6));
+	output.Append(side_string, strlen(side_string));
 
-			for (int j = 0; j < book_depth; j++) {
+	if (bid.atMin() || offer == trade_max) {
+		increment.negate();
+	}
 
-				output << "," << midpoints[bond_index] - halfspread_sizes[spread_level[bond_index]] - tick * j << "," << (j+1) * 10000000 << ",BID";
-				output << "," << midpoints[bond_index] + halfspread_sizes[spread_level[bond_index]] + tick * j << "," << (j+1) * 10000000 << ",OFFER";
+	bid   = bid   + increment;
+	offer = offer - increment;
+}
 
-			}
+/**
+ * State shared by the seeded walks of one bond in one file: the mid's random walk and
+ * whether the bond is in a burst.
+ */
+class RandomBondState
+{
+private:
+
+	const GeneratorConfig* config;
+	int mid_ticks;
+	bool in_burst;
+
+public:
+
+	Random random;
+
+	RandomBondState(const GeneratorConfig&, unsigned long long);
+
+	// Number of lines the bond publishes this step
+	int Updates();
+
+	// Move the mid one step and return it in ticks
+	int StepMid();
+
+};
+
+//Seeded market data, variable depth and sizes around a random walk mid
+class RandomMarketDataWalk
+{
+private:
+
+	const std::string* product_id;
+	const std::vector<TreasuryPrices>* halfspread_sizes;
+	const GeneratorConfig* config;
+	RandomBondState state;
+
+public:
+
+	RandomMarketDataWalk(const std::string&, const std::vector<TreasuryPrices>&, const GeneratorConfig&, unsigned long long);
+
+	void Write(OutputBuffer&, int);
+
+};
+
+//Seeded streamed prices, a random discrete spread around a random walk mid
+class RandomPriceWalk
+{
+private:
+
+	const std::string* product_id;
+	const std::vector<TreasuryPrices>* halfspread_sizes;
+	RandomBondState state;
+
+public:
+
+	RandomPriceWalk(const std::string&, const std::vector<TreasuryPrices>&, const GeneratorConfig&, unsigned long long);
+
+	void Write(OutputBuffer&, int);
+
+};
+
+//Seeded trades, one per step at a random side of the spread, book and size
+class RandomTradeWalk
+{
+private:
+
+	const std::string* product_id;
+	const std::vector<TreasuryPrices>* halfspread_sizes;
+	const GeneratorConfig* config;
+	RandomBondState state;
+
+public:
 
-			output << std::endl;
+	RandomTradeWalk(const std::string&, const std::vector<TreasuryPrices>&, const GeneratorConfig&, unsigned long long);
 
-			//If midpoint is at min or max value switch increment direction
-			if (midpoints[bond_index].atMin() || midpoints[bond_index].atMax()) midpoint_increments[bond_index].negate();
-			midpoints[bond_index] = midpoints[bond_index] + midpoint_increments[bond_index];
+	void Write(OutputBuffer&, int);
 
-			//If spread size is at min or max level, switch increment direction
-			if (spread_level[bond_index] == 0 || spread_level[bond_index] == halfspread_sizes.size() - 1) spread_increment_direction[bond_index] *= -1;
-			spread_level[bond_index] += spread_increment_direction[bond_index];
+};
+
+//Seeded inquiries, one per step, ids numbered the same way as the oscillating generator's
+class RandomInquiryWalk
+{
+private:
+
+	const std::string* product_id;
+	int bond_index;
+	int n_bonds;
+	const std::vector<TreasuryPrices>* halfspread_sizes;
+	const GeneratorConfig* config;
+	RandomBondState state;
+
+public:
+
+	RandomInquiryWalk(const std::string&, int, int, const std::vector<TreasuryPrices>&, const GeneratorConfig&, unsigned long long);
+
+	void Write(OutputBuffer&, int);
+
+};
+
+RandomBondState::RandomBondState(const GeneratorConfig& config_, unsigned long long stream) :
+	random(config_.seed, stream)
+{
+	config = &config_;
+	mid_ticks = random.Uniform(config->min_price_ticks, config->max_price_ticks);
+	in_burst = false;
+}
+
+int RandomBondState::Updates() {
+
+	if (in_burst) {
+		if (random.Chance(config->burst_end_probability)) {
+			in_burst = false;
 		}
+		else {
+			return random.Uniform(1, config->burst_updates);
+		}
+	}
+	else if (random.Chance(config->burst_start_probability)) {
+		in_burst = true;
+		return random.Uniform(1, config->burst_updates);
+	}
 
+	return random.Chance(config->quiet_update_probability) ? 1 : 0;
+}
+
+int RandomBondState::StepMid() {
+
+	int step = random.Uniform(-config->mid_step_ticks, config->mid_step_ticks);
+
+	if (random.Chance(config->jump_probability)) {
+		step += random.Uniform(-config->jump_ticks, config->jump_ticks);
 	}
 
-	output.close();
+	mid_ticks += step;
+
+	//Reflect off the bounds, then clamp in case a jump is wider than the range
+	if (mid_ticks < config->min_price_ticks) mid_ticks = 2 * config->min_price_ticks - mid_ticks;
+	if (mid_ticks > config->max_price_ticks) mid_ticks = 2 * config->max_price_ticks - mid_ticks;
+	mid_ticks = std::max(config->min_price_ticks, std::min(config->max_price_ticks, mid_ticks));
+
+	return mid_ticks;
 }
 
-//Generate prices.txt
-void BondGenerator::generatePrices(const int n_updates) {
+RandomMarketDataWalk::RandomMarketDataWalk(const std::string& product_id_, const std::vector<TreasuryPrices>& hs, const GeneratorConfig& config_, unsigned long long stream) :
+	state(config_, stream)
+{
+	product_id = &product_id_;
+	halfspread_sizes = &hs;
+	config = &config_;
+}
 
+void RandomMarketDataWalk::Write(OutputBuffer& output, int) {
 
-	std::ofstream output;
-	output.open("prices.txt");
+	int updates = state.Updates();
+
+	for (int k = 0; k < updates; k++) {
+
+		int mid_ticks = state.StepMid();
+		int halfspread_ticks = (*halfspread_sizes)[state.random.Uniform(0, halfspread_sizes->size() - 1)].toTicks();
+		int book_depth = state.random.Uniform(config->min_depth, config->max_depth);
+
+		output.Append(*product_id);
+		output.Append(',');
+		output.AppendTicks(mid_ticks);
+		output.Append(",MID", 4);
 
-	//Used to oscillate between discrete spread levels
-	std::vector<int> spread_level;
-	std::vector<int> spread_increment_direction;
+		for (int j = 0; j < book_depth; j++) {
 
-	std::vector<TreasuryPrices> bids;
-	std::vector<TreasuryPrices> bid_increments;
+			output.Append(',');
+			output.AppendTicks(mid_ticks - halfspread_ticks - j);
+			output.Append(',');
+			output.AppendInt(state.random.Uniform(config->min_size, config->max_size) * 1000000);
+			output.Append(",BID", 4);
 
-	for (int i = 0; i < bonds.size(); ++i) {
-		bids.push_back(TreasuryPrices(99, 0, 0));
-		bid_increments.push_back(TreasuryPrices(0, 0, -1));
-		spread_level.push_back(0);
-		spread_increment_direction.push_back(-1);
+			output.Append(',');
+			output.AppendTicks(mid_ticks + halfspread_ticks + j);
+			output.Append(',');
+			output.AppendInt(state.random.Uniform(config->min_size, config->max_size) * 1000000);
+			output.Append(",OFFER", 6);
+		}
+
+		output.Append('\n');
 	}
+}
 
-	//Create n_updates for each bond
-	for (int i = 0; i < n_updates; i++) {
+RandomPriceWalk::RandomPriceWalk(const std::string& product_id_, const std::vector<TreasuryPrices>& hs, const GeneratorConfig& config_, unsigned long long stream) :
+	state(config_, stream)
+{
+	product_id = &product_id_;
+	halfspread_sizes = &hs;
+}
 
-		for (int bond_index = 0; bond_index < bonds.size(); bond_index++) {
+void RandomPriceWalk::Write(OutputBuffer& output, int) {
 
-			TreasuryPrices offer = bids[bond_index] + halfspread_sizes[spread_level[bond_index]] * 2;
+	int updates = state.Updates();
 
-			while (offer.gtMax()) {
-				bids[bond_index] = bids[bond_index] - tick;
-				offer = offer - tick;
+	for (int k = 0; k < updates; k++) {
 
-				bid_increments[bond_index] = TreasuryPrices(0, 0, -1);
+		int mid_ticks = state.StepMid();
+		int halfspread_ticks = (*halfspread_sizes)[state.random.Uniform(0, halfspread_sizes->size() - 1)].toTicks();
+
+		output.Append(*product_id);
+		output.Append(',');
+		output.AppendTicks(mid_ticks - halfspread_ticks);
+		output.Append(',');
+		output.AppendTicks(mid_ticks + halfspread_ticks);
+		output.Append('\n');
+	}
+}
+
+RandomTradeWalk::RandomTradeWalk(const std::string& product_id_, const std::vector<TreasuryPrices>& hs, const GeneratorConfig& config_, unsigned long long stream) :
+	state(config_, stream)
+{
+	product_id = &product_id_;
+	halfspread_sizes = &hs;
+	config = &config_;
+}
+
+void RandomTradeWalk::Write(OutputBuffer& output, int) {
+
+	static const char* const books[] = { "TRSY1", "TRSY2", "TRSY3" };
+
+	int mid_ticks = state.StepMid();
+	int halfspread_ticks = (*halfspread_sizes)[state.random.Uniform(0, halfspread_sizes->size() - 1)].toTicks();
+	bool buy = state.random.Chance(0.5);
+
+	output.Append(*product_id);
+	output.Append(",TradeID,", 9);
+	output.AppendTicks(buy ? mid_ticks - halfspread_ticks : mid_ticks + halfspread_ticks);
+	output.Append(',');
+	output.Append(books[state.random.Uniform(0, 2)], 5);
+	output.Append(',');
+	output.AppendInt(state.random.Uniform(config->min_size, config->max_size) * 1000000);
+	output.Append(buy ? ",BUY\n" : ",SELL\n", buy ? 5 : 6);
+}
+
+RandomInquiryWalk::RandomInquiryWalk(const std::string& product_id_, int bond_index_, int n_bonds_, const std::vector<TreasuryPrices>& hs, const GeneratorConfig& config_, unsigned long long stream) :
+	state(config_, stream)
+{
+	product_id = &product_id_;
+	bond_index = bond_index_;
+	n_bonds = n_bonds_;
+	halfspread_sizes = &hs;
+	config = &config_;
+}
+
+void RandomInquiryWalk::Write(OutputBuffer& output, int i) {
+
+	int mid_ticks = state.StepMid();
+	int halfspread_ticks = (*halfspread_sizes)[state.random.Uniform(0, halfspread_sizes->size() - 1)].toTicks();
+	bool buy = state.random.Chance(0.5);
+
+	output.AppendInt(bond_index + n_bonds * i);
+	output.Append(',');
+	output.Append(*product_id);
+	output.Append(buy ? ",BUY," : ",SELL,", buy ? 5 : 6);
+	output.AppendInt(state.random.Uniform(config->min_size, config->max_size) * 1000000);
+	output.Append(',');
+	output.AppendTicks(buy ? mid_ticks + halfspread_ticks : mid_ticks - halfspread_ticks);
+	output.Append(",RECEIVED\n", 10);
+}
+
+//Seeded streams of each file, combined with the bond index
+const unsigned long long MARKET_DATA_STREAM = 1ULL << 32;
+const unsigned long long PRICE_STREAM = 2ULL << 32;
+const unsigned long long TRADE_STREAM = 3ULL << 32;
+const unsigned long long INQUIRY_STREAM = 4ULL << 32;
+
+//Lines of one bond over one chunk of updates, and the offset each update's lines end at
+struct BondChunk
+{
+	OutputBuffer text;
+	std::vector<size_t> update_ends;
+};
+
+template<typename W>
+void BondGenerator::generate(const char* path, const int n_updates, std::vector<W>& walks) {
+
+	std::ofstream output(path, std::ios::binary);
+
+	int n_bonds = walks.size();
+	int n_workers = std::max(1, std::min(n_threads, n_bonds));
+
+	//Chunks cover fewer updates as the universe grows, so memory stays bounded
+	int chunk_updates = std::max(1, chunk_lines / std::max(1, n_bonds));
+
+	std::vector<BondChunk> chunks(n_bonds);
+	OutputBuffer merged;
+
+	for (int start = 0; start < n_updates; start += chunk_updates) {
+
+		int end = std::min(n_updates, start + chunk_updates);
+
+		//Each worker renders the bonds congruent to its index
+		auto render = [&](int worker) {
+			for (int bond_index = worker; bond_index < n_bonds; bond_index += n_workers) {
+
+				BondChunk& chunk = chunks[bond_index];
+				chunk.text.Clear();
+				chunk.update_ends.clear();
+
+				for (int i = start; i < end; i++) {
+					walks[bond_index].Write(chunk.text, i);
+					chunk.update_ends.push_back(chunk.text.Size());
+				}
 			}
+		};
+
+		std::vector<std::thread> workers;
+		for (int w = 1; w < n_workers; w++) {
+			workers.push_back(std::thread(render, w));
+		}
+		render(0);
+		for (size_t w = 0; w < workers.size(); w++) {
+			workers[w].join();
+		}
 
-			output << bonds[bond_index].GetProductId();
-			output << "," << bids[bond_index];
-			output << "," << offer;
-			output << std::endl;
+		//Interleave back to update-major order, every bond's lines for update i before update i + 1
+		merged.Clear();
 
-			if (bids[bond_index].atMin()) bid_increments[bond_index].negate();
-			bids[bond_index] = bids[bond_index] + bid_increments[bond_index];
+		for (int i = 0; i < end - start; i++) {
+			for (int bond_index = 0; bond_index < n_bonds; bond_index++) {
 
-			if (spread_level[bond_index] == 0 || spread_level[bond_index] == halfspread_sizes.size() - 1) spread_increment_direction[bond_index] *= -1;
-			spread_level[bond_index] += spread_increment_direction[bond_index];
+				const BondChunk& chunk = chunks[bond_index];
+				size_t update_start = i == 0 ? 0 : chunk.update_ends[i - 1];
 
+				merged.Append(chunk.text.Data() + update_start, chunk.update_ends[i] - update_start);
+			}
 		}
 
+		merged.WriteTo(output);
 	}
+}
 
-	output.close();
+//Generate marketdata.txt
+void BondGenerator::generateMarketData(const int n_updates, const int book_depth = 5) {
+
+	if (random_walk) {
+
+		std::vector<RandomMarketDataWalk> walks;
+
+		for (size_t bond_index = 0; bond_index < bonds.size(); bond_index++) {
+			walks.push_back(RandomMarketDataWalk(bonds[bond_index].GetProductId(), halfspread_sizes, config, MARKET_DATA_STREAM + bond_index));
+		}
+
+		generate("marketdata.txt", n_updates, walks);
+		return;
+	}
+
+	std::vector<MarketDataWalk> walks;
+
+	for (size_t bond_index = 0; bond_index < bonds.size(); bond_index++) {
+		walks.push_back(MarketDataWalk(bonds[bond_index].GetProductId(), halfspread_sizes, book_depth));
+	}
+
+	generate("marketdata.txt", n_updates, walks);
 }
 
 //Generate prices.txt
+void BondGenerator::generatePrices(const int n_updates) {
+
+	if (random_walk) {
+
+		std::vector<RandomPriceWalk> walks;
+
+		for (size_t bond_index = 0; bond_index < bonds.size(); bond_index++) {
+			walks.push_back(RandomPriceWalk(bonds[bond_index].GetProductId(), halfspread_sizes, config, PRICE_STREAM + bond_index));
+		}
+
+		generate("prices.txt", n_updates, walks);
+		return;
+	}
+
+	std::vector<PriceWalk> walks;
+
+	for (size_t bond_index = 0; bond_index < bonds.size(); bond_index++) {
+		walks.push_back(PriceWalk(bonds[bond_index].GetProductId(), halfspread_sizes));
+	}
+
+	generate("prices.txt", n_updates, walks);
+}
+
+//Generate trades.txt
 void BondGenerator::generateTrades(const int n_trades) {
 
+	if (random_walk) {
 
-	std::ofstream output;
-	output.open("trades.txt");
+		std::vector<RandomTradeWalk> walks;
 
-	std::vector<TreasuryPrices> bids;
-	std::vector<TreasuryPrices> offers;
-	std::vector<TreasuryPrices> increment;
-	
-	//Assume passive trades - buys executed at best bid, asks executed at best offer
-	std::vector<Side> trade_side;
+		for (size_t bond_index = 0; bond_index < bonds.size(); bond_index++) {
+			walks.push_back(RandomTradeWalk(bonds[bond_index].GetProductId(), halfspread_sizes, config, TRADE_STREAM + bond_index));
+		}
 
-	for (int i = 0; i < bonds.size(); ++i) {
-		bids.push_back(TreasuryPrices(99, 0, 0));
-		offers.push_back(TreasuryPrices(100, 0, 0));
-		increment.push_back(TreasuryPrices(0,0,-1));
-		trade_side.push_back(BUY);
+		generate("trades.txt", n_trades, walks);
+		return;
 	}
 
-	std::string side_string;
-	std::string book("TRSY1");
-	TreasuryPrices trade_max(100, 0, 0);
+	std::vector<TradeWalk> walks;
 
-	//Create n_trades for each bond
-	for (int i = 0; i < n_trades; i++) {
+	for (size_t bond_index = 0; bond_index < bonds.size(); bond_index++) {
+		walks.push_back(TradeWalk(bonds[bond_index].GetProductId(), bond_index, bonds.size()));
+	}
 
-		for (int bond_index = 0; bond_index < bonds.size(); bond_index++) {
+	generate("trades.txt", n_trades, walks);
+}
 
-			if (bids[bond_index] == offers[bond_index]) {
-				increment[bond_index].negate();
+//Generate inquiries.txt
+void BondGenerator::generateInquiries(const int n_inquiries) {
 
-				bids[bond_index] = bids[bond_index] + increment[bond_index] * 2;
-				offers[bond_index] = offers[bond_index] - increment[bond_index] * 2;
-			}
+	if (random_walk) {
 
-			output << bonds[bond_index].GetProductId() << ",TradeID";
+		std::vector<RandomInquiryWalk> walks;
 
-			if (trade_side[bond_index] == BUY) {
-				output << "," << bids[bond_index];
-				trade_side[bond_index] = SELL;
-				side_string = "BUY";
-			}
-			else {
-				output << "," << offers[bond_index];
-				trade_side[bond_index] = BUY;
-				side_string = "SELL";
-			}
+		for (size_t bond_index = 0; bond_index < bonds.size(); bond_index++) {
+			walks.push_back(RandomInquiryWalk(bonds[bond_index].GetProductId(), bond_index, bonds.size(), halfspread_sizes, config, INQUIRY_STREAM + bond_index));
+		}
 
-			output << "," << book;
+		generate("inquiries.txt", n_inquiries, walks);
+		return;
+	}
 
-			if (book == "TRSY1") {
-				book = "TRSY2";
-			}
-			else if (book == "TRSY2") {
-				book = "TRSY3";
-			}
-			else {
-				book = "TRSY1";
-			}
+	std::ofstream output;
+	output.open("inquiries.txt");
+
+	std::vector<Side> trade_side;
+
+	for (size_t i = 0; i < bonds.size(); ++i) {
+		trade_side.push_back(BUY);
+	}
 
-			output << "," << 1000000 * (1 + i % 6) << "," << side_string;
-			output << std::endl;
+	for (int i = 0; i < n_inquiries; i++) {
+
+		for (size_t bond_index = 0; bond_index < bonds.size(); bond_index++) {
 
-			if (bids[bond_index].atMin() || offers[bond_index] == trade_max) {
-				increment[bond_index].negate();
+			output << bond_index + bonds.size() * i << "," << bonds[bond_index].GetProductId();
+
+			if (trade_side[bond_index] == BUY) {
+				output << ",BUY";
+				trade_side[bond_index] = SELL;
+			}
+			else{
+				output << ",SELL";
+				trade_side[bond_index] = BUY;
 			}
 
-			bids[bond_index]   = bids[bond_index]   + increment[bond_index];
-			offers[bond_index] = offers[bond_index] - increment[bond_index];
+			//Old way to generate random numbers - biased - but don't have to deal with include<random> and out of date g++ issues
+			//Not allowing 101 to make computation easier
+			output << "," << (1 + std::rand() % 5) * 1000000;
+			output << "," << TreasuryPrices(99 + std::rand() % 2, std::rand() % (32), std::rand() % 8);
+			output << ",RECEIVED" << std::endl;
 
 		}
 
 	}
 
 	output.close();
+
 }
 
 #endif
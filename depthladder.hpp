@@ -0,0 +1,206 @@
+/**
+ * depthladder.hpp
+ * Aggregates the orders of a book by price into flat arrays, through a ladder of
+ * quantities indexed by tick.
+ *
+ */
+#ifndef DEPTH_LADDER_HPP
+#define DEPTH_LADDER_HPP
+
+#include <vector>
+#include <algorithm>
+#include "marketdataservice.hpp"
+
+using namespace std;
+
+//Half-tick slots in the ladder, four points. Sides spanning more are sorted instead.
+const int DEPTH_LADDER_UNITS = 2048;
+
+/**
+ * Aggregated levels of one side in ascending price, pointing into the arrays of the
+ * DepthLadder that produced it. Valid until that ladder aggregates again.
+ */
+class DepthSide
+{
+private:
+
+	const TickPrice* prices;
+	const long* quantities;
+	size_t levels;
+
+public:
+
+	DepthSide();
+
+	DepthSide(const TickPrice* prices_, const long* quantities_, size_t levels_);
+
+	size_t Levels() const;
+
+	TickPrice Price(size_t i) const;
+
+	long Quantity(size_t i) const;
+
+};
+
+//Aggregated bid and offer sides of one book
+class DepthView
+{
+private:
+
+	DepthSide bids;
+	DepthSide offers;
+
+public:
+
+	DepthView(const DepthSide& bids_, const DepthSide& offers_);
+
+	const DepthSide& GetBids() const;
+
+	const DepthSide& GetOffers() const;
+
+};
+
+/**
+ * Sums quantity per price. Each side's orders land in a ladder slot indexed by their
+ * distance in half ticks from the side's lowest price, and one pass over the occupied span
+ * emits the levels already sorted. Output arrays and the ladder are reused across calls,
+ * so after the first few books aggregation allocates nothing.
+ */
+class DepthLadder
+{
+private:
+
+	vector<long> ladder;
+	vector<char> occupied;
+
+	//Copy of a side sorted by price, for sides too wide for the ladder
+	vector<Order> scratch;
+
+	vector<TickPrice> bid_prices;
+	vector<long> bid_quantities;
+	vector<TickPrice> offer_prices;
+	vector<long> offer_quantities;
+
+	// Aggregate one side into prices/quantities
+	DepthSide AggregateSide(const vector<Order>& stack, vector<TickPrice>& prices, vector<long>& quantities);
+
+public:
+
+	DepthLadder();
+
+	DepthView Aggregate(const vector<Order>& bid_stack, const vector<Order>& offer_stack);
+
+};
+
+DepthSide::DepthSide() {
+	prices = NULL;
+	quantities = NULL;
+	levels = 0;
+}
+
+DepthSide::DepthSide(const TickPrice* prices_, const long* quantities_, size_t levels_) {
+	prices = prices_;
+	quantities = quantities_;
+	levels = levels_;
+}
+
+size_t DepthSide::Levels() const {
+	return levels;
+}
+
+TickPrice DepthSide::Price(size_t i) const {
+	return prices[i];
+}
+
+long DepthSide::Quantity(size_t i) const {
+	return quantities[i];
+}
+
+DepthView::DepthView(const DepthSide& bids_, const DepthSide& offers_) :
+	bids(bids_), offers(offers_)
+{
+}
+
+const DepthSide& DepthView::GetBids() const {
+	return bids;
+}
+
+const DepthSide& DepthView::GetOffers() const {
+	return offers;
+}
+
+DepthLadder::DepthLadder() :
+	ladder(DEPTH_LADDER_UNITS, 0),
+	occupied(DEPTH_LADDER_UNITS, 0)
+{
+}
+
+//Ascending price, for the sides sorted outside the ladder
+bool price_before(const Order& a, const Order& b) {
+	return a.GetPrice() < b.GetPrice();
+}
+
+DepthSide DepthLadder::AggregateSide(const vector<Order>& stack, vector<TickPrice>& prices, vector<long>& quantities) {
+
+	prices.clear();
+	quantities.clear();
+
+	if (stack.empty()) {
+		return DepthSide();
+	}
+
+	int low = stack[0].GetPrice().toUnits(), high = low;
+
+	for (size_t i = 1; i < stack.size(); i++) {
+		low = min(low, stack[i].GetPrice().toUnits());
+		high = max(high, stack[i].GetPrice().toUnits());
+	}
+
+	if (high - low < DEPTH_LADDER_UNITS) {
+
+		for (size_t i = 0; i < stack.size(); i++) {
+
+			int slot = stack[i].GetPrice().toUnits() - low;
+
+			if (!occupied[slot]) {
+				occupied[slot] = 1;
+				ladder[slot] = 0;
+			}
+			ladder[slot] += stack[i].GetQuantity();
+		}
+
+		//Emit and clear the occupied slots in price order
+		for (int slot = 0; slot <= high - low; slot++) {
+			if (occupied[slot]) {
+				prices.push_back(TickPrice::fromUnits(low + slot));
+				quantities.push_back(ladder[slot]);
+				occupied[slot] = 0;
+			}
+		}
+	}
+	else {
+
+		scratch.assign(stack.begin(), stack.end());
+		sort(scratch.begin(), scratch.end(), price_before);
+
+		for (size_t i = 0; i < scratch.size(); i++) {
+			if (!prices.empty() && prices.back() == scratch[i].GetPrice()) {
+				quantities.back() += scratch[i].GetQuantity();
+			}
+			else {
+				prices.push_back(scratch[i].GetPrice());
+				quantities.push_back(scratch[i].GetQuantity());
+			}
+		}
+	}
+
+	return DepthSide(&prices[0], &quantities[0], prices.size());
+}
+
+DepthView DepthLadder::Aggregate(const vector<Order>& bid_stack, const vector<Order>& offer_stack) {
+	DepthSide bids = AggregateSide(bid_stack, bid_prices, bid_quantities);
+	DepthSide offers = AggregateSide(offer_stack, offer_prices, offer_quantities);
+	return DepthView(bids, offers);
+}
+
+#endif
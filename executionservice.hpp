@@ -9,6 +9,7 @@
 
 #include <string>
 #include "soa.hpp"
+#include "tickprice.hpp"
 #include "marketdataservice.hpp"
 
 enum OrderType { FOK, IOC, MARKET, LIMIT, STOP };
@@ -27,11 +28,14 @@ public:
 
   ExecutionOrder();
   // ctor for an order
-  ExecutionOrder(const T &_product, PricingSide _side, string _orderId, OrderType _orderType, double _price, long _visibleQuantity, long _hiddenQuantity, string _parentOrderId, bool _isChildOrder);
+  ExecutionOrder(const T &_product, PricingSide _side, string _orderId, OrderType _orderType, TickPrice _price, long _visibleQuantity, long _hiddenQuantity, string _parentOrderId, bool _isChildOrder);
 
   // Get the product
   const T& GetProduct() const;
 
+  // Get the dense index of the product
+  int GetProductIndex() const;
+
   // Get the order ID
   const string& GetOrderId() const;
 
@@ -39,7 +43,7 @@ public:
   OrderType GetOrderType() const;
 
   // Get the price on this order
-  double GetPrice() const;
+  TickPrice GetPrice() const;
 
   // Get the visible quantity on this order
   long GetVisibleQuantity() const;
@@ -56,11 +60,12 @@ public:
   PricingSide GetSide() const;
 
 private:
-  T product;
+  const T* product;
+  int productIndex;
   PricingSide side;
   string orderId;
   OrderType orderType;
-  double price;
+  TickPrice price;
   long visibleQuantity;
   long hiddenQuantity;
   string parentOrderId;
@@ -85,12 +90,16 @@ public:
 };
 
 template <typename T>
-ExecutionOrder<T>::ExecutionOrder() {}
+ExecutionOrder<T>::ExecutionOrder() {
+  product = NULL;
+  productIndex = -1;
+}
 
 template<typename T>
-ExecutionOrder<T>::ExecutionOrder(const T &_product, PricingSide _side, string _orderId, OrderType _orderType, double _price, long _visibleQuantity, long _hiddenQuantity, string _parentOrderId, bool _isChildOrder) :
-  product(_product)
+ExecutionOrder<T>::ExecutionOrder(const T &_product, PricingSide _side, string _orderId, OrderType _orderType, TickPrice _price, long _visibleQuantity, long _hiddenQuantity, string _parentOrderId, bool _isChildOrder) :
+  product(&_product)
 {
+  productIndex = _product.GetProductIndex();
   side = _side;
   orderId = _orderId;
   orderType = _orderType;
@@ -104,7 +113,13 @@ ExecutionOrder<T>::ExecutionOrder(const T &_product, PricingSide _side, string _
 template<typename T>
 const T& ExecutionOrder<T>::GetProduct() const
 {
-  return product;
+  return *product;
+}
+
+template<typename T>
+int ExecutionOrder<T>::GetProductIndex() const
+{
+  return productIndex;
 }
 
 template<typename T>
@@ -120,7 +135,7 @@ OrderType ExecutionOrder<T>::GetOrderType() const
 }
 
 template<typename T>
-double ExecutionOrder<T>::GetPrice() const
+TickPrice ExecutionOrder<T>::GetPrice() const
 {
   return price;
 }
@@ -0,0 +1,137 @@
+/**
+ * generatorconfig.hpp
+ * Settings for the random walk data BondGenerator produces when given a seed, and the
+ * seeded generator behind it.
+ *
+ */
+#ifndef GENERATOR_CONFIG_HPP
+#define GENERATOR_CONFIG_HPP
+
+#include "treasuryprices.hpp"
+
+/**
+ * xoshiro256** seeded through splitmix64. Implemented here rather than taken from <random>
+ * so a seed produces the same files with every compiler and standard library.
+ */
+class Random
+{
+private:
+
+	unsigned long long state[4];
+
+	static unsigned long long rotl(unsigned long long x, int k);
+
+public:
+
+	//Independent streams per seed, one per file and bond
+	Random(unsigned long long seed, unsigned long long stream = 0);
+
+	unsigned long long Next();
+
+	// Uniform integer in [lo, hi]
+	int Uniform(int lo, int hi);
+
+	// Uniform double in [0, 1)
+	double UniformReal();
+
+	// True with probability p
+	bool Chance(double p);
+
+};
+
+/**
+ * Shape of the generated data. Prices are in 1/256 ticks and sizes in millions of face value.
+ * Each step a bond's mid moves up to mid_step_ticks either way and, with jump_probability,
+ * jumps up to jump_ticks more, reflecting off the price bounds. Bonds switch between a quiet
+ * state, publishing with quiet_update_probability, and bursts of up to burst_updates lines a
+ * step, entered and left with the burst probabilities.
+ */
+struct GeneratorConfig
+{
+	unsigned long long seed;
+
+	int min_price_ticks;
+	int max_price_ticks;
+	int mid_step_ticks;
+	double jump_probability;
+	int jump_ticks;
+
+	double quiet_update_probability;
+	double burst_start_probability;
+	double burst_end_probability;
+	int burst_updates;
+
+	int min_depth;
+	int max_depth;
+	int min_size;
+	int max_size;
+
+	GeneratorConfig(unsigned long long seed_ = 1);
+};
+
+unsigned long long Random::rotl(unsigned long long x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+Random::Random(unsigned long long seed, unsigned long long stream) {
+
+	unsigned long long x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+
+	for (int i = 0; i < 4; i++) {
+		x += 0x9E3779B97F4A7C15ULL;
+		unsigned long long z = x;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		state[i] = z ^ (z >> 31);
+	}
+}
+
+unsigned long long Random::Next() {
+
+	unsigned long long result = rotl(state[1] * 5, 7) * 9;
+	unsigned long long t = state[1] << 17;
+
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = rotl(state[3], 45);
+
+	return result;
+}
+
+int Random::Uniform(int lo, int hi) {
+	return lo + (int) (Next() % (unsigned long long) (hi - lo + 1));
+}
+
+double Random::UniformReal() {
+	return (Next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+bool Random::Chance(double p) {
+	return UniformReal() < p;
+}
+
+GeneratorConfig::GeneratorConfig(unsigned long long seed_) {
+
+	seed = seed_;
+
+	min_price_ticks = 99 * TICKS_PER_POINT;
+	max_price_ticks = 101 * TICKS_PER_POINT;
+	mid_step_ticks = 1;
+	jump_probability = 0.001;
+	jump_ticks = 32;
+
+	quiet_update_probability = 0.5;
+	burst_start_probability = 0.01;
+	burst_end_probability = 0.1;
+	burst_updates = 8;
+
+	min_depth = 1;
+	max_depth = 10;
+	min_size = 1;
+	max_size = 50;
+}
+
+#endif
@@ -7,30 +7,27 @@
 #include <fstream>
 #include "soa.hpp"
 #include "bondpricingservice.hpp"
+#include "keyedstore.hpp"
 
 class PriceTime
 {
 private:
-	//Price<Bond> p;
-	Bond b;
-	double mid;
-	double spread;
+	Price<Bond> p;
 	long ms;
 public:
-	PriceTime(Bond, double, double, long);
+	PriceTime(const Price<Bond>&, long);
 	Price<Bond> GetPrice();
 	long GetTime();
 };
 
-PriceTime::PriceTime(Bond b_, double mid_, double spread_, long ms_) {
-	b = b_;
-	mid = mid_;
-	spread = spread_;
+PriceTime::PriceTime(const Price<Bond>& p_, long ms_) :
+	p(p_)
+{
 	ms = ms_;
 }
 
 Price<Bond> PriceTime::GetPrice() {
-	return Price<Bond>(b,mid,spread);
+	return p;
 }
 
 long PriceTime::GetTime() {
@@ -43,11 +40,7 @@ class GUIConnector;
 class GUIService : public Service<string, Price<Bond> >{
 private:
 	
-	vector<string> product_vec;
-	vector<Bond> products;
-	vector<double> mids;
-	vector<double> spreads;
-	//vector<Price<Bond> > price_vec;
+	ProductStore<Price<Bond> > price_store;
 	vector<ServiceListener<Price<Bond> >* > listeners;
 	GUIConnector* gui_connector;
 	int max_updates;
@@ -116,7 +109,7 @@ public:
 
 	void Subscribe();
 
-	setGUIService(GUIService*);
+	void setGUIService(GUIService*);
 
 };
 
@@ -127,28 +120,13 @@ GUIService::GUIService(GUIConnector* gui_connector_) {
 
 // Get data on our service given a key
 Price<Bond> GUIService::GetData(string product_id) {
-	int index = find(product_vec.begin(), product_vec.end(), product_id) - product_vec.begin();
-	return Price<Bond>(products[index], mids[index], spreads[index]);
-	//return price_vec[index];
+	return *price_store.Find(product_id);
 }
 
 // The callback that a Connector should invoke for any new or updated data
 void GUIService::OnMessage(Price <Bond>& prc) {
 	
-	int index = find(product_vec.begin(), product_vec.end(), prc.GetProduct().GetProductId()) - product_vec.begin();
-
-	if (index < product_vec.size()) {
-		product_vec.erase(product_vec.begin() + index);
-		products.erase(products.begin() + index);
-		mids.erase(mids.begin() + index);
-		spreads.erase(spreads.begin() + index);
-	}
-
-	product_vec.push_back(prc.GetProduct().GetProductId());
-	products.push_back(prc.GetProduct());
-	mids.push_back(prc.GetMid());
-	spreads.push_back(prc.GetBidOfferSpread());
-	//price_vec.push_back(p);
+	price_store.Put(prc.GetProductIndex(), prc.GetProduct().GetProductId(), prc);
 
 	for (int i = 0; i < listeners.size(); i++) {
 		listeners[i]->ProcessAdd(prc);
@@ -177,7 +155,7 @@ void GUIService::PublishPrice(Price<Bond>& prc, long ms) {
 	}
 	max_updates--;
 
-	PriceTime pt(prc.GetProduct(), prc.GetMid(), prc.GetBidOfferSpread(), ms);
+	PriceTime pt(prc, ms);
 	gui_connector->Publish(pt);
 }
 
@@ -236,7 +214,7 @@ void GUIConnector::Publish(PriceTime& ps) {
 
 void GUIConnector::Subscribe() {}
 
-GUIConnector::setGUIService(GUIService* gui_service_) {
+void GUIConnector::setGUIService(GUIService* gui_service_) {
 	gui_service = gui_service_;
 }
 
@@ -32,6 +32,9 @@ public:
   // Get the product
   const T& GetProduct() const;
 
+  // Get the dense index of the product
+  int GetProductIndex() const;
+
   // Get the side on the inquiry
   Side GetSide() const;
 
@@ -50,7 +53,8 @@ public:
 
 private:
   string inquiryId;
-  T product;
+  const T* product;
+  int productIndex;
   Side side;
   long quantity;
   double price;
@@ -79,8 +83,9 @@ public:
 
 template<typename T>
 Inquiry<T>::Inquiry(string _inquiryId, const T &_product, Side _side, long _quantity, double _price, InquiryState _state) :
-  product(_product)
+  product(&_product)
 {
+  productIndex = _product.GetProductIndex();
   inquiryId = _inquiryId;
   side = _side;
   quantity = _quantity;
@@ -97,7 +102,13 @@ const string& Inquiry<T>::GetInquiryId() const
 template<typename T>
 const T& Inquiry<T>::GetProduct() const
 {
-  return product;
+  return *product;
+}
+
+template<typename T>
+int Inquiry<T>::GetProductIndex() const
+{
+  return productIndex;
 }
 
 template<typename T>
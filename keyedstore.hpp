@@ -0,0 +1,342 @@
+/**
+ * keyedstore.hpp
+ * Open-addressing hash store keeping the latest value per key, used by the services
+ * in place of parallel key/value vectors.
+ *
+ */
+#ifndef KEYED_STORE_HPP
+#define KEYED_STORE_HPP
+
+#include <string>
+#include <vector>
+#include "stringview.hpp"
+
+using namespace std;
+
+//Hash functor used by KeyedStore
+template<typename K>
+struct KeyHash;
+
+//FNV-1a over the characters of the key
+template<>
+struct KeyHash<StringView>
+{
+	size_t operator()(StringView key) const {
+		unsigned long long h = 14695981039346656037ULL;
+		for (size_t i = 0; i < key.size(); i++) {
+			h ^= (unsigned char) key[i];
+			h *= 1099511628211ULL;
+		}
+		return (size_t) h;
+	}
+};
+
+//Same hash as the StringView, so a view can be looked up against string keys
+template<>
+struct KeyHash<string>
+{
+	size_t operator()(const string& key) const {
+		return KeyHash<StringView>()(StringView(key));
+	}
+};
+
+//Fibonacci hashing so consecutive ids spread over the table
+template<>
+struct KeyHash<int>
+{
+	size_t operator()(int key) const {
+		return (size_t) (((unsigned long long) (unsigned int) key * 11400714819323198485ULL) >> 16);
+	}
+};
+
+//Fibonacci hashing on the full 64 bits, for order ids
+template<>
+struct KeyHash<unsigned long long>
+{
+	size_t operator()(unsigned long long key) const {
+		return (size_t) ((key * 11400714819323198485ULL) >> 16);
+	}
+};
+
+/**
+ * Store of values keyed on K with O(1) lookup and in place updates.
+ * Values live in a dense vector in insertion order, the hash table only holds indices
+ * into it, so iterating the store walks contiguous memory.
+ * Type V must be copy constructible and assignable.
+ */
+template<typename K, typename V, typename H = KeyHash<K> >
+class KeyedStore
+{
+private:
+
+	vector<K> keys;
+	vector<V> values;
+
+	//Open-addressing table of indices into keys/values, -1 marks an empty slot
+	vector<int> slots;
+	size_t mask;
+	H hasher;
+
+	//Slot holding key, or the empty slot where it would be inserted
+	size_t Probe(const K& key) const;
+
+	//Double the table and reinsert every key
+	void Grow();
+
+public:
+
+	KeyedStore();
+
+	// Get the value stored for key, NULL if the key has never been stored
+	V* Find(const K& key);
+	const V* Find(const K& key) const;
+
+	bool Contains(const K& key) const;
+
+	// Store value under key, overwriting the previous value in place
+	V& Put(const K& key, const V& value);
+
+	// Remove key, false if it was not stored. The last value moves into its place, so
+	// insertion order and pointers to that value are not preserved.
+	bool Erase(const K& key);
+
+	// Number of keys in the store
+	size_t Size() const;
+
+	// Dense access in insertion order
+	const K& KeyAt(size_t i) const;
+	V& ValueAt(size_t i);
+	const V& ValueAt(size_t i) const;
+	const vector<V>& Values() const;
+
+	// Preallocate for n keys
+	void Reserve(size_t n);
+
+};
+
+template<typename K, typename V, typename H>
+KeyedStore<K, V, H>::KeyedStore() {
+	slots.assign(16, -1);
+	mask = 15;
+}
+
+template<typename K, typename V, typename H>
+size_t KeyedStore<K, V, H>::Probe(const K& key) const {
+
+	size_t pos = hasher(key) & mask;
+
+	//Load factor is kept at or below 1/2 so there is always an empty slot
+	while (slots[pos] != -1 && !(keys[slots[pos]] == key)) {
+		pos = (pos + 1) & mask;
+	}
+
+	return pos;
+}
+
+template<typename K, typename V, typename H>
+void KeyedStore<K, V, H>::Grow() {
+
+	slots.assign(slots.size() * 2, -1);
+	mask = slots.size() - 1;
+
+	for (size_t i = 0; i < keys.size(); i++) {
+		slots[Probe(keys[i])] = (int) i;
+	}
+}
+
+template<typename K, typename V, typename H>
+V* KeyedStore<K, V, H>::Find(const K& key) {
+	int index = slots[Probe(key)];
+	return index == -1 ? NULL : &values[index];
+}
+
+template<typename K, typename V, typename H>
+const V* KeyedStore<K, V, H>::Find(const K& key) const {
+	int index = slots[Probe(key)];
+	return index == -1 ? NULL : &values[index];
+}
+
+template<typename K, typename V, typename H>
+bool KeyedStore<K, V, H>::Contains(const K& key) const {
+	return slots[Probe(key)] != -1;
+}
+
+template<typename K, typename V, typename H>
+V& KeyedStore<K, V, H>::Put(const K& key, const V& value) {
+
+	size_t pos = Probe(key);
+
+	if (slots[pos] != -1) {
+		values[slots[pos]] = value;
+		return values[slots[pos]];
+	}
+
+	keys.push_back(key);
+	values.push_back(value);
+	slots[pos] = (int) keys.size() - 1;
+
+	if (keys.size() * 2 > slots.size()) {
+		Grow();
+	}
+
+	return values.back();
+}
+
+template<typename K, typename V, typename H>
+bool KeyedStore<K, V, H>::Erase(const K& key) {
+
+	size_t pos = Probe(key);
+	int index = slots[pos];
+
+	if (index == -1) {
+		return false;
+	}
+
+	//Keep keys/values dense by moving the last entry into the hole
+	int last = (int) keys.size() - 1;
+	if (index != last) {
+		slots[Probe(keys[last])] = index;
+		keys[index] = keys[last];
+		values[index] = values[last];
+	}
+	keys.pop_back();
+	values.pop_back();
+
+	//Backward shift deletion, entries later in the probe run move up into the gap unless
+	//that would put them ahead of their home slot
+	size_t gap = pos;
+	slots[gap] = -1;
+
+	for (size_t next = (gap + 1) & mask; slots[next] != -1; next = (next + 1) & mask) {
+
+		size_t home = hasher(keys[slots[next]]) & mask;
+
+		if (((next - home) & mask) >= ((next - gap) & mask)) {
+			slots[gap] = slots[next];
+			slots[next] = -1;
+			gap = next;
+		}
+	}
+
+	return true;
+}
+
+template<typename K, typename V, typename H>
+size_t KeyedStore<K, V, H>::Size() const {
+	return keys.size();
+}
+
+template<typename K, typename V, typename H>
+const K& KeyedStore<K, V, H>::KeyAt(size_t i) const {
+	return keys[i];
+}
+
+template<typename K, typename V, typename H>
+V& KeyedStore<K, V, H>::ValueAt(size_t i) {
+	return values[i];
+}
+
+template<typename K, typename V, typename H>
+const V& KeyedStore<K, V, H>::ValueAt(size_t i) const {
+	return values[i];
+}
+
+template<typename K, typename V, typename H>
+const vector<V>& KeyedStore<K, V, H>::Values() const {
+	return values;
+}
+
+template<typename K, typename V, typename H>
+void KeyedStore<K, V, H>::Reserve(size_t n) {
+
+	keys.reserve(n);
+	values.reserve(n);
+
+	if (n * 2 > slots.size()) {
+
+		size_t size = slots.size();
+		while (n * 2 > size) {
+			size *= 2;
+		}
+
+		slots.assign(size / 2, -1);
+		Grow();
+	}
+}
+
+/**
+ * Store of the latest value per product, indexed directly by the dense product index
+ * assigned by BondUniverseService so the hot path never hashes a product id.
+ * Lookups by product id go through a KeyedStore of indices.
+ * Type V must be copy constructible and assignable.
+ */
+template<typename V>
+class ProductStore
+{
+private:
+
+	vector<V> values;
+	vector<char> present;
+	KeyedStore<string, int> indices;
+
+public:
+
+	// Get the value stored for a product, NULL if the product has never been stored
+	V* Find(int productIndex);
+	const V* Find(int productIndex) const;
+	V* Find(const string& productId);
+	const V* Find(const string& productId) const;
+
+	// Store value for a product, overwriting the previous value in place
+	V& Put(int productIndex, const string& productId, const V& value);
+
+	// One past the highest product index stored, for visiting every product with Find
+	int EndIndex() const;
+
+};
+
+template<typename V>
+V* ProductStore<V>::Find(int productIndex) {
+	return productIndex >= 0 && productIndex < (int) present.size() && present[productIndex] ? &values[productIndex] : NULL;
+}
+
+template<typename V>
+const V* ProductStore<V>::Find(int productIndex) const {
+	return productIndex >= 0 && productIndex < (int) present.size() && present[productIndex] ? &values[productIndex] : NULL;
+}
+
+template<typename V>
+V* ProductStore<V>::Find(const string& productId) {
+	const int* index = indices.Find(productId);
+	return index == NULL ? NULL : &values[*index];
+}
+
+template<typename V>
+const V* ProductStore<V>::Find(const string& productId) const {
+	const int* index = indices.Find(productId);
+	return index == NULL ? NULL : &values[*index];
+}
+
+template<typename V>
+V& ProductStore<V>::Put(int productIndex, const string& productId, const V& value) {
+
+	if (productIndex >= (int) values.size()) {
+		values.resize(productIndex + 1, value);
+		present.resize(productIndex + 1, 0);
+	}
+
+	if (!present[productIndex]) {
+		present[productIndex] = 1;
+		indices.Put(productId, productIndex);
+	}
+
+	values[productIndex] = value;
+	return values[productIndex];
+}
+
+template<typename V>
+int ProductStore<V>::EndIndex() const {
+	return (int) values.size();
+}
+
+#endif
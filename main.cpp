@@ -13,6 +13,10 @@
 #include "bondstreamingservice.hpp"
 #include "guiservice.hpp"
 #include "bondhistoricaldataservice.hpp"
+#include "threadedpipeline.hpp"
+#ifdef STATIC_PIPELINE
+#include "staticpipeline.hpp"
+#endif
 
 int main() {
 
@@ -23,6 +27,18 @@ int main() {
 	halfspreads.push_back(TreasuryPrices(0, 0, 3));
 	halfspreads.push_back(TreasuryPrices(0, 0, 4));
 
+	BondUniverseService bond_uni_service;
+
+	//-DUNIVERSE_SIZE=n trades n synthetic bonds loaded from a generated bonds.txt in place of the
+	//on the run treasuries, with fewer updates per bond so the total number of updates is unchanged
+#ifdef UNIVERSE_SIZE
+	generate_reference_data("bonds.txt", UNIVERSE_SIZE);
+
+	BondUniverseConnector uni_connector(&bond_uni_service);
+	uni_connector.Subscribe("bonds.txt");
+
+	const int n_updates = std::max(1, (int) (1e6 * 7 / UNIVERSE_SIZE));
+#else
 	Bond bond_two("91282CFX4", CUSIP, "T", 4.5, "20241130");
 	Bond bond_three("91282CGA3", CUSIP, "T", 4.0, "20251215");
 	Bond bond_five("91282CFZ9", CUSIP, "T", 3.875, "20271130");
@@ -31,8 +47,6 @@ int main() {
 	Bond bond_twenty("912810TM0", CUSIP, "T", 4.0, "20421115");
 	Bond bond_thirty("912810TL2", CUSIP, "T", 4.0, "20521115");
 
-	BondUniverseService bond_uni_service;
-
 	bond_uni_service.OnMessage(bond_two);
 	bond_uni_service.OnMessage(bond_three);
 	bond_uni_service.OnMessage(bond_five);
@@ -41,24 +55,52 @@ int main() {
 	bond_uni_service.OnMessage(bond_twenty);
 	bond_uni_service.OnMessage(bond_thirty);
 
-	BondGenerator g(bond_uni_service.GetUniverse(), halfspreads);
+	const int n_updates = 1e6;
+#endif
+
+	//Market data, prices and trades are rendered a bond per thread and written in large chunks.
+	//-DRANDOM_WALK_SEED=n replaces the fixed oscillation with seeded random walks and bursts
+#ifdef RANDOM_WALK_SEED
+	BondGenerator g(bond_uni_service.GetUniverse(), halfspreads, GeneratorConfig(RANDOM_WALK_SEED), std::max(1u, std::thread::hardware_concurrency()));
+#else
+	BondGenerator g(bond_uni_service.GetUniverse(), halfspreads, std::max(1u, std::thread::hardware_concurrency()));
+#endif
 
-	g.generateMarketData(1e6, 5);
+	g.generateMarketData(n_updates, 5);
 
-	g.generatePrices(1e6);
+	g.generatePrices(n_updates);
 
 	g.generateTrades(10);
 
 	g.generateInquiries(10);
 
+	//-DTHREADED_PIPELINE runs each decoupled listener and everything downstream of it on its own
+	//thread, -DPIN_PIPELINE_THREADS additionally pins those threads to separate cpus, and
+	//-DCONFLATE_SLOW_CONSUMERS has the GUI and streaming stages see only the latest price per bond
+#if defined(THREADED_PIPELINE) && defined(PIN_PIPELINE_THREADS)
+	ThreadedPipeline pipeline(true, 1 << 12, true);
+#elif defined(THREADED_PIPELINE)
+	ThreadedPipeline pipeline(true, 1 << 12, false);
+#else
+	ThreadedPipeline pipeline(false, 0, false);
+#endif
+
+#ifdef STATIC_PIPELINE
+	//Market data and trade booking chains dispatch through compile-time listener sets
+	StaticExecutionPipeline exec_pipeline(&bond_uni_service);
+	BondMarketDataConnector& md_connector = exec_pipeline.GetMarketDataConnector();
+#else
 	BondMarketDataService md_service;
 	BondMarketDataConnector md_connector(&md_service, &bond_uni_service);
+#endif
 
 	BondPricingService prc_service;
 	BondPricingConnector prc_connector(&prc_service, &bond_uni_service);
 
+#ifndef STATIC_PIPELINE
 	BondTradeBookingService btb_service;
 	BondTradeBookingConnector btb_connector(&btb_service, &bond_uni_service);
+#endif
 
 	BondInquiryConnector inq_connector;
 	BondInquiryService inq_service(&inq_connector);
@@ -67,27 +109,42 @@ int main() {
 	BondInquiryServiceListener inq_listener(&inq_service);
 	inq_service.AddListener(&inq_listener);
 
+#ifndef STATIC_PIPELINE
 	BondPositionService pos_service;
 	BondRiskService risk_service;
 
 	BondTradeBookingServiceListener trade_book_listener(&pos_service);
-	btb_service.AddListener(&trade_book_listener);
+	btb_service.AddListener(pipeline.Decouple(&trade_book_listener));
 	BondPositionServiceListener pos_listener(&risk_service);
 	pos_service.AddListener(&pos_listener);
 
 	BondAlgoExecutionService algo_exec_service;
 	BondMarketDataServiceListener md_listener(&algo_exec_service);
+	//-DTOP_OF_BOOK_FILTER only hands the algo the books whose best bid or offer changed,
+	//-DCONSOLIDATED_MARKET_DATA routes by the venue books, read as they are published
+#if defined(CONSOLIDATED_MARKET_DATA)
+	md_listener.RouteByVenue(&md_service.GetConsolidatedBooks());
 	md_service.AddListener(&md_listener);
+#elif defined(TOP_OF_BOOK_FILTER)
+	md_service.AddTopOfBookListener(pipeline.Decouple(&md_listener));
+#else
+	md_service.AddListener(pipeline.Decouple(&md_listener));
+#endif
 	
 	BondExecutionConnector exec_connector;
 	BondExecutionService exec_service(&exec_connector);
 	exec_connector.setBondExecutionService(&exec_service);
 	BondAlgoExecutionServiceListener algo_exec_listener(&exec_service);
 	algo_exec_service.AddListener(&algo_exec_listener);
+#endif
 
 	BondAlgoStreamingService algo_stream_service;
 	BondPricingServiceListener prc_listener(&algo_stream_service);
-	prc_service.AddListener(&prc_listener);
+#ifdef CONFLATE_SLOW_CONSUMERS
+	prc_service.AddListener(pipeline.Conflate(&prc_listener));
+#else
+	prc_service.AddListener(pipeline.Decouple(&prc_listener));
+#endif
 
 	BondStreamingConnector stream_connector;
 	BondStreamingService stream_service(&stream_connector);
@@ -99,40 +156,106 @@ int main() {
 	GUIService gui_service(&gui_connector);
 	gui_connector.setGUIService(&gui_service);
 	BondPricingServiceToGUIListener prc_listener_gui(&gui_service);
-	prc_service.AddListener(&prc_listener_gui);
+#ifdef CONFLATE_SLOW_CONSUMERS
+	prc_service.AddListener(pipeline.Conflate(&prc_listener_gui));
+#else
+	prc_service.AddListener(pipeline.Decouple(&prc_listener_gui));
+#endif
 
+#ifndef STATIC_PIPELINE
 	BondHistoricalDataConnector< ExecutionOrder<Bond> > historical_exe_connector;
+#endif
 	BondHistoricalDataConnector< Inquiry<Bond> > historical_inq_connector;
+#ifndef STATIC_PIPELINE
 	BondHistoricalDataConnector< Position<Bond> > historical_pos_connector;
+#endif
 	BondHistoricalDataConnector< PriceStream<Bond> > historical_ps_connector;
+#ifndef STATIC_PIPELINE
 	BondHistoricalDataConnector< PV01<Bond> > historical_pv_connector;
+#endif
 		
-	BondHistoricalDataService< ExecutionOrder<Bond> > historical_exe_service(&historical_exe_connector);
 	BondHistoricalDataService< Inquiry<Bond> > historical_inq_service (&historical_inq_connector);
-	BondHistoricalDataService< Position<Bond> > historical_pos_service (&historical_pos_connector);
 	BondHistoricalDataService< PriceStream<Bond> > historical_ps_service (&historical_ps_connector);
+	historical_inq_connector.setBondService(&historical_inq_service);
+	historical_ps_connector.setBondService(&historical_ps_service);
+
+	ServiceListenerToHistorical< Inquiry<Bond> > inq_listener_historical(&historical_inq_service);
+	ServiceListenerToHistorical< PriceStream<Bond> > ps_listener_historical(&historical_ps_service);
+	stream_service.AddListener(pipeline.Decouple(&ps_listener_historical));
+	inq_service.AddListener(&inq_listener_historical);
+
+#ifndef STATIC_PIPELINE
+	BondHistoricalDataService< ExecutionOrder<Bond> > historical_exe_service(&historical_exe_connector);
+	BondHistoricalDataService< Position<Bond> > historical_pos_service (&historical_pos_connector);
 	BondHistoricalDataService< PV01<Bond> > historical_pv_service (&historical_pv_connector);
 	
 	historical_exe_connector.setBondService(&historical_exe_service);
-	historical_inq_connector.setBondService(&historical_inq_service);
 	historical_pos_connector.setBondService(&historical_pos_service);
-	historical_ps_connector.setBondService(&historical_ps_service);
 	historical_pv_connector.setBondService(&historical_pv_service);	
 
 	ServiceListenerToHistorical< ExecutionOrder<Bond> > exe_listener_historical(&historical_exe_service);
-	ServiceListenerToHistorical< Inquiry<Bond> > inq_listener_historical(&historical_inq_service);
 	ServiceListenerToHistorical< Position<Bond> > pos_listener_historical(&historical_pos_service);
-	ServiceListenerToHistorical< PriceStream<Bond> > ps_listener_historical(&historical_ps_service);
 	ServiceListenerToHistorical< PV01<Bond> > pv_listener_historical(&historical_pv_service);
 
-	exec_service.AddListener(&exe_listener_historical);
-	stream_service.AddListener(&ps_listener_historical);
-	inq_service.AddListener(&inq_listener_historical);
-	pos_service.AddListener(&pos_listener_historical);
-	risk_service.AddListener(&pv_listener_historical);
+	exec_service.AddListener(pipeline.Decouple(&exe_listener_historical));
+	pos_service.AddListener(pipeline.Decouple(&pos_listener_historical));
+	risk_service.AddListener(pipeline.Decouple(&pv_listener_historical));
+#endif
 	
+	//-DBINARY_MARKET_DATA converts marketdata.txt to fixed-width records once and replays those
+#ifdef BINARY_MARKET_DATA
+	convert_market_data("marketdata.txt", "marketdata.bin");
+#endif
+
+	//-DSNAPSHOT_INTERVAL=n snapshots the books every n market data lines. A run finding a snapshot
+	//whose market data up to it and bond universe match this run's restores it and replays only
+	//the messages after it, otherwise it replays everything.
+#ifdef SNAPSHOT_INTERVAL
+#ifdef STATIC_PIPELINE
+	StaticBondMarketDataService& md_service = exec_pipeline.GetMarketDataService();
+#endif
+	md_service.EnableSnapshots("marketdata.snapshot", SNAPSHOT_INTERVAL);
+#ifdef BINARY_MARKET_DATA
+	md_connector.Recover("marketdata.snapshot", "marketdata.bin");
+#else
+	md_connector.Recover("marketdata.snapshot", "marketdata.txt");
+#endif
+#endif
+
+	//-DSHARED_STATE mirrors the latest price and position per bond into shared memory, for other
+	//processes to read through SharedStateReader
+#ifdef SHARED_STATE
+	SharedStateWriter shared_state("/tradingsystem", bond_uni_service.GetUniverse());
+	if (shared_state.IsOpen()) {
+		prc_service.PublishTo(shared_state.Prices());
+#ifdef STATIC_PIPELINE
+		exec_pipeline.GetPositionService().PublishTo(shared_state.Positions());
+#else
+		pos_service.PublishTo(shared_state.Positions());
+#endif
+	}
+#endif
+
+	//-DBINARY_MARKET_DATA replays the converted records, -DINCREMENTAL_MARKET_DATA sends the
+	//service only the levels each line changes,
+	//-DCONSOLIDATED_MARKET_DATA takes the lines as books from each venue in turn and merges them
+#if defined(CONSOLIDATED_MARKET_DATA)
+	md_connector.SubscribeVenues();
+#elif defined(BINARY_MARKET_DATA)
+	md_connector.SubscribeBinary();
+#elif defined(INCREMENTAL_MARKET_DATA)
+	md_connector.SubscribeIncremental();
+#else
 	md_connector.Subscribe();
+#endif
 	prc_connector.Subscribe();
+#ifdef STATIC_PIPELINE
+	exec_pipeline.SubscribeTrades();
+#else
 	btb_connector.Subscribe();
+#endif
 	inq_connector.Subscribe();
+
+	//Drain the stages before the services they feed go out of scope
+	pipeline.Stop();
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+/**
+ * mappedfile.hpp
+ * Read-only memory mapping of an input file, which Tokenizer splits into lines and
+ * comma separated fields as StringViews into the mapping.
+ *
+ */
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define MAPPED_FILE_MMAP
+#endif
+#include "stringview.hpp"
+
+using namespace std;
+
+/**
+ * Whole file mapped read-only for the life of the object. Where mmap is unavailable, or the
+ * mapping fails, the file is read into a buffer instead so callers see the same interface.
+ * A missing or empty file has no data, like an ifstream that fails to open.
+ */
+class MappedFile
+{
+private:
+
+	const char* begin;
+	size_t length;
+	bool mapped;
+
+	//Fallback storage when the file could not be mapped
+	vector<char> buffer;
+
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	// Read the whole file into buffer
+	void ReadFallback(const char* path);
+
+public:
+
+	MappedFile(const char* path);
+
+	~MappedFile();
+
+	const char* data() const;
+
+	size_t size() const;
+
+};
+
+MappedFile::MappedFile(const char* path) {
+
+	begin = NULL;
+	length = 0;
+	mapped = false;
+
+#ifdef MAPPED_FILE_MMAP
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+
+		void* p = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (p != MAP_FAILED) {
+			begin = (const char*) p;
+			length = (size_t) st.st_size;
+			mapped = true;
+
+			//Connectors read front to back
+			madvise(p, length, MADV_SEQUENTIAL);
+		}
+	}
+
+	close(fd);
+
+	if (mapped) {
+		return;
+	}
+#endif
+
+	ReadFallback(path);
+}
+
+MappedFile::~MappedFile() {
+#ifdef MAPPED_FILE_MMAP
+	if (mapped) {
+		munmap((void*) begin, length);
+	}
+#endif
+}
+
+void MappedFile::ReadFallback(const char* path) {
+
+	ifstream input_file(path, ios::binary);
+	buffer.assign(istreambuf_iterator<char>(input_file), istreambuf_iterator<char>());
+
+	begin = buffer.empty() ? NULL : &buffer[0];
+	length = buffer.size();
+}
+
+const char* MappedFile::data() const {
+	return begin;
+}
+
+size_t MappedFile::size() const {
+	return length;
+}
+
+#endif
@@ -0,0 +1,419 @@
+/**
+ * marketbyorder.hpp
+ * Market by order book: individual resting orders keyed by order id, queued in time
+ * priority at each price, with the aggregated level view derived from them.
+ *
+ */
+#ifndef MARKET_BY_ORDER_HPP
+#define MARKET_BY_ORDER_HPP
+
+#include <vector>
+#include "marketdataservice.hpp"
+#include "keyedstore.hpp"
+
+using namespace std;
+
+//Resting order, linked into the FIFO of its price level by pool index, -1 ending the list
+struct BookOrder
+{
+	unsigned long long order_id;
+	TickPrice price;
+	PricingSide side;
+	long quantity;
+	int prev;
+	int next;
+};
+
+//Total quantity and FIFO ends of the orders resting at one price
+struct PriceLevel
+{
+	long quantity;
+	int order_count;
+	int head;
+	int tail;
+};
+
+/**
+ * Fixed-size nodes handed out by index. Released nodes go on a free list and are reused
+ * before the pool grows, so a book in steady state allocates nothing per order.
+ * Indices stay valid when the pool grows, pointers and references do not.
+ */
+template<typename N>
+class NodePool
+{
+private:
+
+	vector<N> nodes;
+	vector<int> free_nodes;
+
+public:
+
+	// Index of an unused node, its contents are left for the caller to set
+	int Allocate();
+
+	void Release(int index);
+
+	N& operator[](int index);
+	const N& operator[](int index) const;
+
+	// Preallocate for n nodes
+	void Reserve(size_t n);
+
+};
+
+/**
+ * Order book built from order level events, as sent by venues' L3 feeds. Add, cancel and
+ * execute are O(1) hash and list operations, except that the first order at a new price
+ * or the last one leaving a price also inserts or removes it in the short best price first
+ * list of prices on that side.
+ * Type T is the product type.
+ */
+template<typename T>
+class MarketByOrderBook
+{
+private:
+
+	const T* product;
+
+	NodePool<BookOrder> orders;
+	KeyedStore<unsigned long long, int> order_index;
+
+	//Per side, BID then OFFER: levels keyed on price in half ticks, and their prices best first
+	KeyedStore<int, PriceLevel> levels[2];
+	vector<TickPrice> prices[2];
+
+	// Append an order to the tail of its level, creating the level if needed
+	void Link(int node);
+
+	// Take an order out of its level, removing the level once empty
+	void Unlink(int node);
+
+public:
+
+	MarketByOrderBook(const T& _product, size_t reserved_orders = 1024);
+
+	// Get the product
+	const T& GetProduct() const;
+
+	// Rest a new order at the back of its price, false if the id is live or quantity isn't positive
+	bool Add(unsigned long long order_id, PricingSide side, TickPrice price, long quantity);
+
+	// Remove an order, false if the id isn't live
+	bool Cancel(unsigned long long order_id);
+
+	// Change an order's quantity. A reduction keeps its place in the queue, an increase
+	// sends it to the back, as venues treat them. Zero cancels it.
+	bool Modify(unsigned long long order_id, long quantity);
+
+	// Fill up to quantity of an order, removing it once fully filled. Returns the quantity filled.
+	long Execute(unsigned long long order_id, long quantity);
+
+	// Get a live order, NULL if the id isn't live. Valid until the book next changes.
+	const BookOrder* Find(unsigned long long order_id) const;
+
+	// Quantity queued ahead of an order at its price, -1 if the id isn't live. Walks the queue.
+	long QueueAhead(unsigned long long order_id) const;
+
+	// Number of live orders
+	size_t OrderCount() const;
+
+	// Number of prices on a side, and the price and total quantity of level i, best first
+	size_t Levels(PricingSide side) const;
+	TickPrice LevelPrice(PricingSide side, size_t i) const;
+	long LevelQuantity(PricingSide side, size_t i) const;
+
+	// Level view of the book, quantity summed per price, best price first
+	void FillLevels(vector<Order>& bid_stack, vector<Order>& offer_stack) const;
+
+	// Level view of the book as an OrderBook
+	OrderBook<T> GetOrderBook() const;
+
+};
+
+template<typename N>
+int NodePool<N>::Allocate() {
+
+	if (!free_nodes.empty()) {
+		int index = free_nodes.back();
+		free_nodes.pop_back();
+		return index;
+	}
+
+	nodes.push_back(N());
+	return (int) nodes.size() - 1;
+}
+
+template<typename N>
+void NodePool<N>::Release(int index) {
+	free_nodes.push_back(index);
+}
+
+template<typename N>
+N& NodePool<N>::operator[](int index) {
+	return nodes[index];
+}
+
+template<typename N>
+const N& NodePool<N>::operator[](int index) const {
+	return nodes[index];
+}
+
+template<typename N>
+void NodePool<N>::Reserve(size_t n) {
+	nodes.reserve(n);
+	free_nodes.reserve(n);
+}
+
+template<typename T>
+MarketByOrderBook<T>::MarketByOrderBook(const T& _product, size_t reserved_orders) {
+	product = &_product;
+	orders.Reserve(reserved_orders);
+	order_index.Reserve(reserved_orders);
+}
+
+template<typename T>
+const T& MarketByOrderBook<T>::GetProduct() const {
+	return *product;
+}
+
+template<typename T>
+void MarketByOrderBook<T>::Link(int node) {
+
+	BookOrder& order = orders[node];
+	int side = order.side == BID ? 0 : 1;
+
+	PriceLevel* level = levels[side].Find(order.price.toUnits());
+
+	if (level == NULL) {
+
+		PriceLevel empty;
+		empty.quantity = 0;
+		empty.order_count = 0;
+		empty.head = -1;
+		empty.tail = -1;
+		level = &levels[side].Put(order.price.toUnits(), empty);
+
+		//New price goes ahead of the first worse one
+		vector<TickPrice>& side_prices = prices[side];
+		size_t i = 0;
+		while (i < side_prices.size() && (side == 0 ? side_prices[i] > order.price : side_prices[i] < order.price)) {
+			i++;
+		}
+		side_prices.insert(side_prices.begin() + i, order.price);
+	}
+
+	order.prev = level->tail;
+	order.next = -1;
+
+	if (level->tail == -1) {
+		level->head = node;
+	}
+	else {
+		orders[level->tail].next = node;
+	}
+
+	level->tail = node;
+	level->quantity += order.quantity;
+	level->order_count++;
+}
+
+template<typename T>
+void MarketByOrderBook<T>::Unlink(int node) {
+
+	BookOrder& order = orders[node];
+	int side = order.side == BID ? 0 : 1;
+
+	PriceLevel* level = levels[side].Find(order.price.toUnits());
+
+	if (order.prev == -1) {
+		level->head = order.next;
+	}
+	else {
+		orders[order.prev].next = order.next;
+	}
+
+	if (order.next == -1) {
+		level->tail = order.prev;
+	}
+	else {
+		orders[order.next].prev = order.prev;
+	}
+
+	level->quantity -= order.quantity;
+	level->order_count--;
+
+	if (level->order_count == 0) {
+
+		levels[side].Erase(order.price.toUnits());
+
+		vector<TickPrice>& side_prices = prices[side];
+		size_t i = 0;
+		while (side_prices[i] != order.price) {
+			i++;
+		}
+		side_prices.erase(side_prices.begin() + i);
+	}
+}
+
+template<typename T>
+bool MarketByOrderBook<T>::Add(unsigned long long order_id, PricingSide side, TickPrice price, long quantity) {
+
+	if (quantity <= 0 || order_index.Contains(order_id)) {
+		return false;
+	}
+
+	int node = orders.Allocate();
+
+	BookOrder& order = orders[node];
+	order.order_id = order_id;
+	order.price = price;
+	order.side = side;
+	order.quantity = quantity;
+
+	Link(node);
+	order_index.Put(order_id, node);
+
+	return true;
+}
+
+template<typename T>
+bool MarketByOrderBook<T>::Cancel(unsigned long long order_id) {
+
+	const int* node = order_index.Find(order_id);
+
+	if (node == NULL) {
+		return false;
+	}
+
+	int index = *node;
+
+	Unlink(index);
+	orders.Release(index);
+	order_index.Erase(order_id);
+
+	return true;
+}
+
+template<typename T>
+bool MarketByOrderBook<T>::Modify(unsigned long long order_id, long quantity) {
+
+	const int* node = order_index.Find(order_id);
+
+	if (node == NULL) {
+		return false;
+	}
+
+	if (quantity <= 0) {
+		return Cancel(order_id);
+	}
+
+	BookOrder& order = orders[*node];
+
+	if (quantity <= order.quantity) {
+		int side = order.side == BID ? 0 : 1;
+		levels[side].Find(order.price.toUnits())->quantity -= order.quantity - quantity;
+		order.quantity = quantity;
+	}
+	else {
+		Unlink(*node);
+		order.quantity = quantity;
+		Link(*node);
+	}
+
+	return true;
+}
+
+template<typename T>
+long MarketByOrderBook<T>::Execute(unsigned long long order_id, long quantity) {
+
+	const int* node = order_index.Find(order_id);
+
+	if (node == NULL || quantity <= 0) {
+		return 0;
+	}
+
+	BookOrder& order = orders[*node];
+
+	if (quantity >= order.quantity) {
+		long filled = order.quantity;
+		Cancel(order_id);
+		return filled;
+	}
+
+	int side = order.side == BID ? 0 : 1;
+	levels[side].Find(order.price.toUnits())->quantity -= quantity;
+	order.quantity -= quantity;
+
+	return quantity;
+}
+
+template<typename T>
+const BookOrder* MarketByOrderBook<T>::Find(unsigned long long order_id) const {
+	const int* node = order_index.Find(order_id);
+	return node == NULL ? NULL : &orders[*node];
+}
+
+template<typename T>
+long MarketByOrderBook<T>::QueueAhead(unsigned long long order_id) const {
+
+	const int* node = order_index.Find(order_id);
+
+	if (node == NULL) {
+		return -1;
+	}
+
+	long ahead = 0;
+
+	for (int i = orders[*node].prev; i != -1; i = orders[i].prev) {
+		ahead += orders[i].quantity;
+	}
+
+	return ahead;
+}
+
+template<typename T>
+size_t MarketByOrderBook<T>::OrderCount() const {
+	return order_index.Size();
+}
+
+template<typename T>
+size_t MarketByOrderBook<T>::Levels(PricingSide side) const {
+	return prices[side == BID ? 0 : 1].size();
+}
+
+template<typename T>
+TickPrice MarketByOrderBook<T>::LevelPrice(PricingSide side, size_t i) const {
+	return prices[side == BID ? 0 : 1][i];
+}
+
+template<typename T>
+long MarketByOrderBook<T>::LevelQuantity(PricingSide side, size_t i) const {
+	int s = side == BID ? 0 : 1;
+	return levels[s].Find(prices[s][i].toUnits())->quantity;
+}
+
+template<typename T>
+void MarketByOrderBook<T>::FillLevels(vector<Order>& bid_stack, vector<Order>& offer_stack) const {
+
+	bid_stack.clear();
+	offer_stack.clear();
+
+	for (size_t i = 0; i < Levels(BID); i++) {
+		bid_stack.push_back(Order(LevelPrice(BID, i), LevelQuantity(BID, i), BID));
+	}
+
+	for (size_t i = 0; i < Levels(OFFER); i++) {
+		offer_stack.push_back(Order(LevelPrice(OFFER, i), LevelQuantity(OFFER, i), OFFER));
+	}
+}
+
+template<typename T>
+OrderBook<T> MarketByOrderBook<T>::GetOrderBook() const {
+
+	vector<Order> bid_stack, offer_stack;
+	FillLevels(bid_stack, offer_stack);
+
+	return OrderBook<T>(*product, bid_stack, offer_stack);
+}
+
+#endif
@@ -0,0 +1,329 @@
+/**
+ * marketdatabinary.hpp
+ * Fixed-width binary order book records, a converter from marketdata.txt, a writer for
+ * book snapshots, and a reader over a memory-mapped file of either.
+ *
+ */
+#ifndef MARKET_DATA_BINARY_HPP
+#define MARKET_DATA_BINARY_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include "mappedfile.hpp"
+#include "marketdatatext.hpp"
+#include "keyedstore.hpp"
+
+using namespace std;
+
+//Records are stored little-endian and read in place
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#error "binary market data is little-endian and read in place, big-endian hosts are not supported"
+#endif
+
+//Levels stored per side, deeper levels in the text are dropped by the converter
+const int BINARY_BOOK_LEVELS = 10;
+
+//Longest product id stored, ISINs are 12 characters
+const int BINARY_BOOK_ID_SIZE = 12;
+
+const uint32_t BINARY_BOOK_VERSION = 2;
+
+/**
+ * One order book snapshot, 256 bytes. The product id is padded with NULs, prices are
+ * 1/256 tick counts, and only the first bid_levels/offer_levels entries of each side
+ * are meaningful. Every field sits at its natural alignment in a mapped file.
+ */
+struct BinaryBook
+{
+	char product_id[BINARY_BOOK_ID_SIZE];
+	uint16_t bid_levels;
+	uint16_t offer_levels;
+	int32_t bid_ticks[BINARY_BOOK_LEVELS];
+	int32_t offer_ticks[BINARY_BOOK_LEVELS];
+	int64_t bid_quantities[BINARY_BOOK_LEVELS];
+	int64_t offer_quantities[BINARY_BOOK_LEVELS];
+};
+
+/**
+ * Where the messages in a snapshot's books came from. Replay resumes at offset in the
+ * source's messages, source_hash covers the message bytes around the start and the resume
+ * point, and universe_hash the product ids, so a snapshot of other data is never applied.
+ */
+struct SnapshotOrigin
+{
+	uint64_t offset;
+	uint64_t source_hash;
+	uint64_t universe_hash;
+};
+
+//Leads the file, records follow at offset sizeof(BinaryBookHeader)
+struct BinaryBookHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t record_size;
+	uint64_t record_count;
+	//Sequence of the last market data message in a snapshot's books and where it came from,
+	//0 in converted files
+	uint64_t sequence;
+	SnapshotOrigin origin;
+	uint64_t reserved;
+};
+
+static_assert(sizeof(BinaryBook) == 256, "BinaryBook layout changed");
+static_assert(sizeof(BinaryBookHeader) == 64, "BinaryBookHeader layout changed");
+
+//Bytes of a source hashed at its start and before the resume point
+const size_t SNAPSHOT_SOURCE_BLOCK = 4096;
+
+const char BINARY_BOOK_MAGIC[8] = { 'T', 'S', 'B', 'O', 'O', 'K', 'S', '\0' };
+
+//Snapshots of every book share the record layout under their own magic
+const char BINARY_SNAPSHOT_MAGIC[8] = { 'T', 'S', 'S', 'N', 'A', 'P', 'S', '\0' };
+
+// Convert a marketdata.txt style file to binary records, returns the number of books written
+size_t convert_market_data(const char* text_path, const char* binary_path);
+
+// Set book to product_id and the first BINARY_BOOK_LEVELS levels of each stack
+void pack_binary_book(BinaryBook& book, StringView product_id, const vector<Order>& bid_stack, const vector<Order>& offer_stack);
+
+// Replace the stacks with the levels of book
+void unpack_binary_book(const BinaryBook& book, vector<Order>& bid_stack, vector<Order>& offer_stack);
+
+// Messages of a market data source, the records past a binary file's header, whose count
+// changes as the file grows, or else the whole text
+StringView snapshot_messages(const char* source, size_t size);
+
+// Hash of the first SNAPSHOT_SOURCE_BLOCK bytes of a source and of those ending at offset,
+// so it only depends on the source before offset and holds as the source grows
+uint64_t snapshot_source_hash(const char* source, size_t offset);
+
+/**
+ * Writes binary book records a block at a time behind a header, which Close rewrites
+ * with the final count. Nothing is readable at path until Close.
+ */
+class BinaryBookWriter
+{
+private:
+
+	ofstream output;
+	BinaryBookHeader header;
+	vector<BinaryBook> books;
+
+	void Flush();
+
+public:
+
+	BinaryBookWriter(const char* path, const char magic[8] = BINARY_BOOK_MAGIC);
+
+	void Write(const BinaryBook& book);
+
+	// Write out the remaining records and the header, returns the number of records
+	size_t Close(uint64_t sequence = 0, const SnapshotOrigin& origin = SnapshotOrigin());
+
+};
+
+/**
+ * Records of a binary market data file, mapped and used in place. A file with a bad
+ * header, or truncated, reads as empty.
+ */
+class BinaryBookReader
+{
+private:
+
+	MappedFile file;
+	const BinaryBook* records;
+	size_t count;
+	uint64_t sequence;
+	SnapshotOrigin origin;
+
+public:
+
+	BinaryBookReader(const char* path, const char magic[8] = BINARY_BOOK_MAGIC);
+
+	size_t Count() const;
+
+	// Sequence recorded in the header, 0 unless a snapshot
+	uint64_t Sequence() const;
+
+	// Origin recorded in the header, zeros unless a snapshot
+	const SnapshotOrigin& Origin() const;
+
+	const BinaryBook& Record(size_t i) const;
+
+	// The whole file, header included
+	const char* Data() const;
+
+	// Product id of a record without its padding
+	StringView ProductId(size_t i) const;
+
+};
+
+size_t convert_market_data(const char* text_path, const char* binary_path) {
+
+	MarketDataTextReader input_file(text_path);
+	StringView product_id;
+	vector<Order> bid_stack, offer_stack;
+
+	BinaryBookWriter output(binary_path);
+	BinaryBook book;
+
+	while (input_file.Next(product_id, bid_stack, offer_stack)) {
+		pack_binary_book(book, product_id, bid_stack, offer_stack);
+		output.Write(book);
+	}
+
+	return output.Close();
+}
+
+void pack_binary_book(BinaryBook& book, StringView product_id, const vector<Order>& bid_stack, const vector<Order>& offer_stack) {
+
+	memset(&book, 0, sizeof(book));
+	memcpy(book.product_id, product_id.data(), min(product_id.size(), (size_t) BINARY_BOOK_ID_SIZE));
+
+	for (size_t k = 0; k < bid_stack.size() && book.bid_levels < BINARY_BOOK_LEVELS; k++) {
+		book.bid_ticks[book.bid_levels] = bid_stack[k].GetPrice().toTicks();
+		book.bid_quantities[book.bid_levels] = bid_stack[k].GetQuantity();
+		book.bid_levels++;
+	}
+
+	for (size_t k = 0; k < offer_stack.size() && book.offer_levels < BINARY_BOOK_LEVELS; k++) {
+		book.offer_ticks[book.offer_levels] = offer_stack[k].GetPrice().toTicks();
+		book.offer_quantities[book.offer_levels] = offer_stack[k].GetQuantity();
+		book.offer_levels++;
+	}
+}
+
+void unpack_binary_book(const BinaryBook& book, vector<Order>& bid_stack, vector<Order>& offer_stack) {
+
+	bid_stack.clear();
+	offer_stack.clear();
+
+	for (int k = 0; k < book.bid_levels; k++) {
+		bid_stack.push_back(Order(TickPrice::fromTicks(book.bid_ticks[k]), book.bid_quantities[k], BID));
+	}
+
+	for (int k = 0; k < book.offer_levels; k++) {
+		offer_stack.push_back(Order(TickPrice::fromTicks(book.offer_ticks[k]), book.offer_quantities[k], OFFER));
+	}
+}
+
+StringView snapshot_messages(const char* source, size_t size) {
+
+	if (size >= sizeof(BinaryBookHeader) && memcmp(source, BINARY_BOOK_MAGIC, sizeof(BINARY_BOOK_MAGIC)) == 0) {
+		return StringView(source + sizeof(BinaryBookHeader), size - sizeof(BinaryBookHeader));
+	}
+
+	return StringView(source, size);
+}
+
+uint64_t snapshot_source_hash(const char* source, size_t offset) {
+
+	KeyHash<StringView> hash;
+
+	size_t block = min(offset, SNAPSHOT_SOURCE_BLOCK);
+
+	uint64_t h = hash(StringView(source, block));
+	return h * 1099511628211ULL ^ hash(StringView(source + offset - block, block));
+}
+
+BinaryBookWriter::BinaryBookWriter(const char* path, const char magic[8]) : output(path, ios::binary) {
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, magic, sizeof(header.magic));
+	header.version = BINARY_BOOK_VERSION;
+	header.record_size = sizeof(BinaryBook);
+
+	//Header goes first with a zero count, rewritten once the count is known
+	output.write((const char*) &header, sizeof(header));
+
+	books.reserve(4096);
+}
+
+void BinaryBookWriter::Flush() {
+
+	if (!books.empty()) {
+		output.write((const char*) &books[0], books.size() * sizeof(BinaryBook));
+		header.record_count += books.size();
+		books.clear();
+	}
+}
+
+void BinaryBookWriter::Write(const BinaryBook& book) {
+
+	books.push_back(book);
+
+	if (books.size() == books.capacity()) {
+		Flush();
+	}
+}
+
+size_t BinaryBookWriter::Close(uint64_t sequence, const SnapshotOrigin& origin) {
+
+	Flush();
+
+	header.sequence = sequence;
+	header.origin = origin;
+	output.seekp(0);
+	output.write((const char*) &header, sizeof(header));
+	output.close();
+
+	return header.record_count;
+}
+
+BinaryBookReader::BinaryBookReader(const char* path, const char magic[8]) : file(path) {
+
+	records = NULL;
+	count = 0;
+	sequence = 0;
+	memset(&origin, 0, sizeof(origin));
+
+	if (file.size() < sizeof(BinaryBookHeader)) {
+		return;
+	}
+
+	const BinaryBookHeader* header = (const BinaryBookHeader*) file.data();
+
+	if (memcmp(header->magic, magic, sizeof(header->magic)) != 0
+		|| header->version != BINARY_BOOK_VERSION
+		|| header->record_size != sizeof(BinaryBook)
+		|| header->record_count > (file.size() - sizeof(BinaryBookHeader)) / sizeof(BinaryBook)) {
+		return;
+	}
+
+	records = (const BinaryBook*) (file.data() + sizeof(BinaryBookHeader));
+	count = header->record_count;
+	sequence = header->sequence;
+	origin = header->origin;
+}
+
+size_t BinaryBookReader::Count() const {
+	return count;
+}
+
+uint64_t BinaryBookReader::Sequence() const {
+	return sequence;
+}
+
+const SnapshotOrigin& BinaryBookReader::Origin() const {
+	return origin;
+}
+
+const BinaryBook& BinaryBookReader::Record(size_t i) const {
+	return records[i];
+}
+
+const char* BinaryBookReader::Data() const {
+	return file.data();
+}
+
+StringView BinaryBookReader::ProductId(size_t i) const {
+	const char* id = records[i].product_id;
+	const char* nul = (const char*) memchr(id, '\0', BINARY_BOOK_ID_SIZE);
+	return StringView(id, nul == NULL ? BINARY_BOOK_ID_SIZE : nul - id);
+}
+
+#endif
@@ -10,12 +10,19 @@
 #include <string>
 #include <vector>
 #include "soa.hpp"
+#include "tickprice.hpp"
 
 using namespace std;
 
 // Side for market data
 enum PricingSide { BID, OFFER };
 
+// Change to one price level of a book, UPDATE_END closes the changes of one update
+enum LevelAction { LEVEL_INSERT, LEVEL_UPDATE, LEVEL_DELETE, UPDATE_END };
+
+// Flags for the sides whose best price or size changed since a book was last published
+enum TopOfBookChange { TOP_UNCHANGED = 0, BID_CHANGED = 1, OFFER_CHANGED = 2 };
+
 /**
  * A market data order with price, quantity, and side.
  */
@@ -25,10 +32,10 @@ class Order
 public:
 
   // ctor for an order
-  Order(double _price, long _quantity, PricingSide _side);
+  Order(TickPrice _price, long _quantity, PricingSide _side);
 
   // Get the price on the order
-  double GetPrice() const;
+  TickPrice GetPrice() const;
 
   // Get the quantity on the order
   long GetQuantity() const;
@@ -37,9 +44,10 @@ public:
   PricingSide GetSide() const;
 
 private:
-  double price;
-  long quantity;
+  // price and side share a word ahead of quantity
+  TickPrice price;
   PricingSide side;
+  long quantity;
 
 };
 
@@ -77,21 +85,55 @@ class OrderBook
 public:
 
   // ctor for the order book
-  OrderBook(T _product, vector<Order>_bidStack, vector<Order>_offerStack);
+  OrderBook(const T &_product, const vector<Order> &_bidStack, const vector<Order> &_offerStack);
 
   // Get the product
   const T& GetProduct() const;
 
+  // Get the dense index of the product
+  int GetProductIndex() const;
+
   // Get the bid stack
   const vector<Order>& GetBidStack() const;
 
   // Get the offer stack
   const vector<Order>& GetOfferStack() const;
 
+  // Get the best bid and offer, kept current as the book changes. An empty side reads as a
+  // zero price and quantity.
+  const BidOffer& GetBestBidOffer() const;
+
+  // Get the TopOfBookChange flags set when the book was published
+  int GetTopOfBookChange() const;
+
+  // Set the TopOfBookChange flags, done by the service publishing the book
+  void SetTopOfBookChange(int change);
+
+  // Get the sequence number of the market data message the book was last updated by, 0 if none
+  unsigned long long GetSequence() const;
+
+  // Set the sequence number, done by the connector reading the message
+  void SetSequence(unsigned long long _sequence);
+
+  // Reserve room for levels per side so applying levels doesn't allocate
+  void Reserve(size_t levels);
+
+  // Insert, update or delete the level at price in place. Stacks changed this way are kept
+  // best price first, an insert at an existing price updates it and an update at a missing
+  // price inserts it.
+  void ApplyLevel(PricingSide side, LevelAction action, TickPrice price, long quantity);
+
 private:
-  T product;
+  const T* product;
+  int productIndex;
   vector<Order> bidStack;
   vector<Order> offerStack;
+  BidOffer bestBidOffer;
+  int topOfBookChange;
+  unsigned long long sequence;
+
+  // best order of a stack in any order, the first of equal prices
+  static Order BestOf(const vector<Order> &stack, PricingSide side);
 
 };
 
@@ -114,14 +156,14 @@ public:
 
 };
 
-Order::Order(double _price, long _quantity, PricingSide _side)
+Order::Order(TickPrice _price, long _quantity, PricingSide _side)
 {
   price = _price;
   quantity = _quantity;
   side = _side;
 }
 
-double Order::GetPrice() const
+TickPrice Order::GetPrice() const
 {
   return price;
 }
@@ -152,16 +194,25 @@ const Order& BidOffer::GetOfferOrder() const
 }
 
 template<typename T>
-OrderBook<T>::OrderBook(T _product, vector<Order> _bidStack, vector<Order> _offerStack) {
-	product = _product;
-	bidStack = _bidStack;
-	offerStack = _offerStack;
+OrderBook<T>::OrderBook(const T &_product, const vector<Order> &_bidStack, const vector<Order> &_offerStack) :
+  product(&_product), bidStack(_bidStack), offerStack(_offerStack),
+  bestBidOffer(BestOf(_bidStack, BID), BestOf(_offerStack, OFFER))
+{
+  productIndex = _product.GetProductIndex();
+  topOfBookChange = BID_CHANGED | OFFER_CHANGED;
+  sequence = 0;
 }
 
 template<typename T>
 const T& OrderBook<T>::GetProduct() const
 {
-  return product;
+  return *product;
+}
+
+template<typename T>
+int OrderBook<T>::GetProductIndex() const
+{
+  return productIndex;
 }
 
 template<typename T>
@@ -176,4 +227,90 @@ const vector<Order>& OrderBook<T>::GetOfferStack() const
   return offerStack;
 }
 
+template<typename T>
+const BidOffer& OrderBook<T>::GetBestBidOffer() const
+{
+  return bestBidOffer;
+}
+
+template<typename T>
+int OrderBook<T>::GetTopOfBookChange() const
+{
+  return topOfBookChange;
+}
+
+template<typename T>
+void OrderBook<T>::SetTopOfBookChange(int change)
+{
+  topOfBookChange = change;
+}
+
+template<typename T>
+unsigned long long OrderBook<T>::GetSequence() const
+{
+  return sequence;
+}
+
+template<typename T>
+void OrderBook<T>::SetSequence(unsigned long long _sequence)
+{
+  sequence = _sequence;
+}
+
+template<typename T>
+Order OrderBook<T>::BestOf(const vector<Order> &stack, PricingSide side)
+{
+  if (stack.empty()) {
+    return Order(TickPrice(), 0, side);
+  }
+
+  size_t best = 0;
+  for (size_t i = 1; i < stack.size(); i++) {
+    if (side == BID ? stack[i].GetPrice() > stack[best].GetPrice() : stack[i].GetPrice() < stack[best].GetPrice()) {
+      best = i;
+    }
+  }
+
+  return stack[best];
+}
+
+template<typename T>
+void OrderBook<T>::Reserve(size_t levels)
+{
+  bidStack.reserve(levels);
+  offerStack.reserve(levels);
+}
+
+template<typename T>
+void OrderBook<T>::ApplyLevel(PricingSide side, LevelAction action, TickPrice price, long quantity)
+{
+  vector<Order> &stack = side == BID ? bidStack : offerStack;
+
+  // first level not better than price, books are a handful of levels so a scan beats a search
+  size_t i = 0;
+  while (i < stack.size() && (side == BID ? stack[i].GetPrice() > price : stack[i].GetPrice() < price)) {
+    i++;
+  }
+
+  bool found = i < stack.size() && stack[i].GetPrice() == price;
+
+  if (action == LEVEL_DELETE) {
+    if (found) {
+      stack.erase(stack.begin() + i);
+    }
+  }
+  else if (found) {
+    stack[i] = Order(price, quantity, side);
+  }
+  else {
+    stack.insert(stack.begin() + i, Order(price, quantity, side));
+  }
+
+  // only a change at the top moves the best level
+  if (i == 0) {
+    Order best = stack.empty() ? Order(TickPrice(), 0, side) : stack.front();
+    bestBidOffer = side == BID ? BidOffer(best, bestBidOffer.GetOfferOrder()) : BidOffer(bestBidOffer.GetBidOrder(), best);
+  }
+}
+
 #endif
@@ -0,0 +1,136 @@
+/**
+ * marketdatatext.hpp
+ * Reader of marketdata.txt lines as order books: the product id, then the bid and offer
+ * levels of the price, quantity, side triplets that follow it.
+ *
+ */
+#ifndef MARKET_DATA_TEXT_HPP
+#define MARKET_DATA_TEXT_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include "mappedfile.hpp"
+#include "tokenizer.hpp"
+#include "treasuryprices.hpp"
+#include "marketdataservice.hpp"
+#include "util.hpp"
+
+using namespace std;
+
+// Start of the line following the first lines lines in [begin, end), end if there are fewer
+const char* skip_lines(const char* begin, const char* end, unsigned long long lines) {
+
+	while (lines > 0 && begin < end) {
+		const char* nl = (const char*) memchr(begin, '\n', end - begin);
+		begin = nl == NULL ? end : nl + 1;
+		lines--;
+	}
+
+	return begin;
+}
+
+/**
+ * Walks a market data file a book per line, every order price on a line parsed in one
+ * pass. Lines are numbered from 1 at the start of the file, passed over lines included,
+ * which is the sequence number the connectors give each book.
+ */
+class MarketDataTextReader
+{
+private:
+
+	MappedFile file;
+	Tokenizer tokenizer;
+	vector<StringView> fields;
+	vector<int> ticks;
+	unsigned long long line;
+
+public:
+
+	// Read path from byte offset, which must start line first_line + 1, as a previous
+	// reader's Line and Offset give
+	MarketDataTextReader(const char* path, unsigned long long first_line = 0, size_t offset = 0);
+
+	// Next book into product_id and the stacks, levels in file order. Lines too short to
+	// hold a book are passed over. false once the file is exhausted.
+	bool Next(StringView& product_id, vector<Order>& bid_stack, vector<Order>& offer_stack);
+
+	// Number of lines read so far, after Next the line of the book it returned
+	unsigned long long Line() const;
+
+	// Byte offset of the line following the last one read
+	size_t Offset() const;
+
+	// The whole file, including what was before the starting offset
+	const char* Data() const;
+	size_t Size() const;
+
+};
+
+MarketDataTextReader::MarketDataTextReader(const char* path, unsigned long long first_line, size_t offset) :
+	file(path), tokenizer(NULL, 0)
+{
+	size_t start = min(offset, file.size());
+
+	tokenizer = Tokenizer(file.data() + start, file.size() - start);
+	line = first_line;
+}
+
+bool MarketDataTextReader::Next(StringView& product_id, vector<Order>& bid_stack, vector<Order>& offer_stack) {
+
+	while (tokenizer.NextLine(fields)) {
+
+		line++;
+
+		if (fields.size() < 3) {
+			continue;
+		}
+
+		bid_stack.clear();
+		offer_stack.clear();
+
+		//First 3 are product id, mid price, MID, the rest price, quantity, Side
+		product_id = fields[0];
+
+		size_t n_orders = (fields.size() - 3) / 3;
+		ticks.resize(n_orders + 1);
+		parse_ticks_batch(&fields[3], n_orders, 3, &ticks[0]);
+
+		for (size_t k = 0; k < n_orders; k++) {
+
+			size_t i = 3 + 3 * k;
+
+			TickPrice price = TickPrice::fromTicks(ticks[k]);
+			long quantity = parse_long(fields[i + 1]);
+
+			if (fields[i + 2] == "BID") {
+				bid_stack.push_back(Order(price, quantity, BID));
+			}
+			else {
+				offer_stack.push_back(Order(price, quantity, OFFER));
+			}
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+unsigned long long MarketDataTextReader::Line() const {
+	return line;
+}
+
+size_t MarketDataTextReader::Offset() const {
+	return tokenizer.Position() - file.data();
+}
+
+const char* MarketDataTextReader::Data() const {
+	return file.data();
+}
+
+size_t MarketDataTextReader::Size() const {
+	return file.size();
+}
+
+#endif
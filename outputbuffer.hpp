@@ -0,0 +1,132 @@
+/**
+ * outputbuffer.hpp
+ * Growable character buffer that text is rendered into before being written out in
+ * a few large writes.
+ *
+ */
+#ifndef OUTPUT_BUFFER_HPP
+#define OUTPUT_BUFFER_HPP
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <ostream>
+#include "treasuryprices.hpp"
+
+using namespace std;
+
+//Room format_price and format_int may write into
+const size_t OUTPUT_BUFFER_FIELD = 40;
+
+/**
+ * Bytes appended at the end, storage only ever grows so a buffer reused across
+ * chunks stops allocating once it has seen the largest one.
+ */
+class OutputBuffer
+{
+private:
+
+	vector<char> storage;
+	size_t length;
+
+	// Make room for n more bytes
+	void Reserve(size_t n);
+
+public:
+
+	OutputBuffer();
+
+	const char* Data() const;
+
+	size_t Size() const;
+
+	// Drop the contents, keeping the storage
+	void Clear();
+
+	void Append(const char* p, size_t n);
+
+	void Append(const string& s);
+
+	void Append(char c);
+
+	// Append n in decimal
+	void AppendInt(int n);
+
+	// Append a price rendered the way operator<< does
+	void AppendPrice(const TreasuryPrices& price);
+
+	// Append the price of a count of 1/256 ticks
+	void AppendTicks(int ticks);
+
+	// Write the contents to output in one call
+	void WriteTo(ostream& output) const;
+
+};
+
+OutputBuffer::OutputBuffer() {
+	length = 0;
+}
+
+void OutputBuffer::Reserve(size_t n) {
+	if (length + n > storage.size()) {
+		storage.resize(max(storage.size() * 2, length + n));
+	}
+}
+
+const char* OutputBuffer::Data() const {
+	return storage.empty() ? NULL : &storage[0];
+}
+
+size_t OutputBuffer::Size() const {
+	return length;
+}
+
+void OutputBuffer::Clear() {
+	length = 0;
+}
+
+void OutputBuffer::Append(const char* p, size_t n) {
+	Reserve(n);
+	memcpy(&storage[length], p, n);
+	length += n;
+}
+
+void OutputBuffer::Append(const string& s) {
+	Append(s.data(), s.size());
+}
+
+void OutputBuffer::Append(char c) {
+	Reserve(1);
+	storage[length++] = c;
+}
+
+void OutputBuffer::AppendInt(int n) {
+	Reserve(OUTPUT_BUFFER_FIELD);
+	length += format_int(n, &storage[length]);
+}
+
+void OutputBuffer::AppendPrice(const TreasuryPrices& price) {
+	Reserve(OUTPUT_BUFFER_FIELD);
+	length += format_price(price, &storage[length]);
+}
+
+void OutputBuffer::AppendTicks(int ticks) {
+	Reserve(OUTPUT_BUFFER_FIELD);
+	if (ticks >= PRICE_TABLE_MIN_TICKS && ticks <= PRICE_TABLE_MAX_TICKS) {
+		const RenderedPrice& r = price_table()[ticks - PRICE_TABLE_MIN_TICKS];
+		memcpy(&storage[length], r.text, sizeof(r.text));
+		length += r.len;
+	}
+	else {
+		length += format_price(TreasuryPrices::fromTicks(ticks), &storage[length]);
+	}
+}
+
+void OutputBuffer::WriteTo(ostream& output) const {
+	if (length > 0) {
+		output.write(&storage[0], length);
+	}
+}
+
+#endif
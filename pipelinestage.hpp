@@ -0,0 +1,42 @@
+/**
+ * pipelinestage.hpp
+ * Common pieces of the stages a ThreadedPipeline runs on their own threads.
+ *
+ */
+#ifndef PIPELINE_STAGE_HPP
+#define PIPELINE_STAGE_HPP
+
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+//Pin a thread to one cpu, no-op where affinity isn't supported or cpu is negative
+void PinThread(thread& t, int cpu) {
+#ifdef __linux__
+	if (cpu >= 0) {
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+		pthread_setaffinity_np(t.native_handle(), sizeof(cpu_set_t), &cpus);
+	}
+#endif
+}
+
+//A pipeline stage that owns a thread and can be drained and stopped
+class PipelineStage
+{
+
+public:
+
+	virtual ~PipelineStage() {}
+
+	// Deliver everything queued so far, then join the stage thread
+	virtual void Stop() = 0;
+
+};
+
+#endif
@@ -30,6 +30,9 @@ public:
   // Get the product
   const T& GetProduct() const;
 
+  // Get the dense index of the product
+  int GetProductIndex() const;
+
   // Get the position quantity
   long GetPosition(string &book);
 
@@ -39,7 +42,8 @@ public:
   long GetAggregatePosition();
 
 private:
-  T product;
+  const T* product;
+  int productIndex;
   map<string,long> positions;
 
 };
@@ -62,14 +66,21 @@ public:
 
 template<typename T>
 Position<T>::Position(const T &_product) :
-  product(_product)
+  product(&_product)
 {
+  productIndex = _product.GetProductIndex();
 }
 
 template<typename T>
 const T& Position<T>::GetProduct() const
 {
-  return product;
+  return *product;
+}
+
+template<typename T>
+int Position<T>::GetProductIndex() const
+{
+  return productIndex;
 }
 
 template<typename T>
@@ -0,0 +1,213 @@
+/**
+ * pricetable.hpp
+ * Fixed table of the latest mid and spread per product, written by one thread and read
+ * consistently by any number of others.
+ *
+ */
+#ifndef PRICE_TABLE_HPP
+#define PRICE_TABLE_HPP
+
+#include <atomic>
+#include <new>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "tickprice.hpp"
+
+using namespace std;
+
+//Bytes in a cache line, which a slot written by one thread and read by others fills alone
+const size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * Sequence lock guarding one slot's values. version is odd while the writer is part way
+ * through an update, and counts two per update published. Values are held in atomics read
+ * and written relaxed between the calls here, whose fences order them, so a torn read is
+ * only ever retried and never a data race. One thread may write, any number may read.
+ */
+struct SeqLock
+{
+	atomic<unsigned int> version;
+
+	SeqLock();
+
+	// Writer side: call before and after storing an update's values
+	void BeginWrite();
+	void EndWrite();
+
+	// Reader side: version to pass to RetryRead after loading the values, which says whether
+	// a write overlapped the loads and they must be repeated
+	unsigned int BeginRead() const;
+	bool RetryRead(unsigned int before) const;
+
+	// Number of updates published
+	unsigned int Updates() const;
+};
+
+//One product's price behind a sequence lock, aligned to a cache line so neighbouring
+//products don't share one
+struct alignas(CACHE_LINE_SIZE) PriceSlot
+{
+	SeqLock lock;
+	atomic<int> mid_units;
+	atomic<int> spread_units;
+
+	PriceSlot();
+};
+
+static_assert(sizeof(PriceSlot) == CACHE_LINE_SIZE, "PriceSlot must fill one cache line");
+
+/**
+ * Latest price per dense product index, sized once so slots never move under a reader.
+ * Publish must only be called from one thread. Read never blocks the writer or other
+ * readers, it copies the slot again only if a write to that product overlapped the copy.
+ */
+class PriceTable
+{
+private:
+
+	//Storage of the slots owned by the table, or none when it views slots held elsewhere. new
+	//only aligns to the largest fundamental alignment before C++17, so this holds a line more
+	//than the slots need and they start at the first line boundary in it.
+	vector<char> owned;
+	PriceSlot* slots;
+	size_t count;
+
+	PriceTable(const PriceTable&);
+	PriceTable& operator=(const PriceTable&);
+
+public:
+
+	PriceTable(size_t products);
+
+	// View over constructed slots the table doesn't own, such as a shared memory segment
+	PriceTable(PriceSlot* slots_, size_t products);
+
+	// Number of product slots
+	size_t Capacity() const;
+
+	// Writer side: publish a product's price, false if the index is outside the table
+	bool Publish(int productIndex, TickPrice mid, TickPrice spread);
+
+	// Any thread: copy out the latest price, false if none has been published. updates, if
+	// given, is set to the number of prices published for the product so far.
+	bool Read(int productIndex, TickPrice& mid, TickPrice& spread, unsigned int* updates = NULL) const;
+
+	// Any thread: number of prices published for a product, to poll for a change cheaply
+	unsigned int Updates(int productIndex) const;
+
+};
+
+SeqLock::SeqLock() : version(0) {}
+
+void SeqLock::BeginWrite() {
+
+	//Odd version first, the release fence keeps the value stores after it
+	version.store(version.load(memory_order_relaxed) + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+void SeqLock::EndWrite() {
+	version.store(version.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+unsigned int SeqLock::BeginRead() const {
+	return version.load(memory_order_acquire);
+}
+
+bool SeqLock::RetryRead(unsigned int before) const {
+
+	//Keeps the value loads ahead of the version check
+	atomic_thread_fence(memory_order_acquire);
+	unsigned int after = version.load(memory_order_relaxed);
+
+	return (before & 1) != 0 || before != after;
+}
+
+unsigned int SeqLock::Updates() const {
+	return version.load(memory_order_acquire) / 2;
+}
+
+PriceSlot::PriceSlot() : mid_units(0), spread_units(0) {}
+
+PriceTable::PriceTable(size_t products) : owned(products == 0 ? 0 : products * sizeof(PriceSlot) + CACHE_LINE_SIZE) {
+
+	slots = NULL;
+	count = products;
+
+	if (products == 0) {
+		return;
+	}
+
+	uintptr_t start = (uintptr_t) &owned[0];
+	slots = (PriceSlot*) ((start + CACHE_LINE_SIZE - 1) & ~(uintptr_t) (CACHE_LINE_SIZE - 1));
+
+	for (size_t i = 0; i < products; i++) {
+		new (&slots[i]) PriceSlot();
+	}
+}
+
+PriceTable::PriceTable(PriceSlot* slots_, size_t products) {
+	slots = slots_;
+	count = products;
+}
+
+size_t PriceTable::Capacity() const {
+	return count;
+}
+
+bool PriceTable::Publish(int productIndex, TickPrice mid, TickPrice spread) {
+
+	if (productIndex < 0 || productIndex >= (int) count) {
+		return false;
+	}
+
+	PriceSlot& slot = slots[productIndex];
+
+	slot.lock.BeginWrite();
+	slot.mid_units.store(mid.toUnits(), memory_order_relaxed);
+	slot.spread_units.store(spread.toUnits(), memory_order_relaxed);
+	slot.lock.EndWrite();
+
+	return true;
+}
+
+bool PriceTable::Read(int productIndex, TickPrice& mid, TickPrice& spread, unsigned int* updates) const {
+
+	if (productIndex < 0 || productIndex >= (int) count) {
+		return false;
+	}
+
+	const PriceSlot& slot = slots[productIndex];
+	unsigned int before;
+	int mid_units, spread_units;
+
+	do {
+		before = slot.lock.BeginRead();
+		mid_units = slot.mid_units.load(memory_order_relaxed);
+		spread_units = slot.spread_units.load(memory_order_relaxed);
+	} while (slot.lock.RetryRead(before));
+
+	if (updates != NULL) {
+		*updates = before / 2;
+	}
+
+	if (before == 0) {
+		return false;
+	}
+
+	mid = TickPrice::fromUnits(mid_units);
+	spread = TickPrice::fromUnits(spread_units);
+	return true;
+}
+
+unsigned int PriceTable::Updates(int productIndex) const {
+
+	if (productIndex < 0 || productIndex >= (int) count) {
+		return 0;
+	}
+
+	return slots[productIndex].lock.Updates();
+}
+
+#endif
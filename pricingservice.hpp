@@ -9,6 +9,7 @@
 
 #include <string>
 #include "soa.hpp"
+#include "tickprice.hpp"
 
 /**
  * A price object consisting of mid and bid/offer spread.
@@ -21,34 +22,27 @@ class Price
 public:
 
   // ctor for a price
-  Price(const T &_product, double _mid, double _bidOfferSpread);
+  Price(const T &_product, TickPrice _mid, TickPrice _bidOfferSpread);
 
   // Get the product
   const T& GetProduct() const;
 
+  // Get the dense index of the product
+  int GetProductIndex() const;
+
   // Get the mid price
-  double GetMid() const;
+  TickPrice GetMid() const;
 
   // Get the bid/offer spread around the mid
-  double GetBidOfferSpread() const;
-
-  //Assignment operator
-  //Price<T>& operator=(const Price<T>& t);
+  TickPrice GetBidOfferSpread() const;
 
 private:
-  const T& product;
-  double mid;
-  double bidOfferSpread;
+  const T* product;
+  int productIndex;
+  TickPrice mid;
+  TickPrice bidOfferSpread;
 
 };
-/*
-template <typename T>
-Price<T>& Price<T>::operator=(const Price<T>& t) {
-	this->product = t.GetProduct();
-	this->mid = t.GetMid();
-	this->bidOfferSpread = t.GetBidOfferSpread();
-}
-*/
 /**
  * Pricing Service managing mid prices and bid/offers.
  * Keyed on product identifier.
@@ -61,9 +55,10 @@ class PricingService : public Service<string,Price <T> >
 
 
 template<typename T>
-Price<T>::Price(const T &_product, double _mid, double _bidOfferSpread) :
-  product(_product)
+Price<T>::Price(const T &_product, TickPrice _mid, TickPrice _bidOfferSpread) :
+  product(&_product)
 {
+  productIndex = _product.GetProductIndex();
   mid = _mid;
   bidOfferSpread = _bidOfferSpread;
 }
@@ -71,17 +66,23 @@ Price<T>::Price(const T &_product, double _mid, double _bidOfferSpread) :
 template<typename T>
 const T& Price<T>::GetProduct() const
 {
-  return product;
+  return *product;
+}
+
+template<typename T>
+int Price<T>::GetProductIndex() const
+{
+  return productIndex;
 }
 
 template<typename T>
-double Price<T>::GetMid() const
+TickPrice Price<T>::GetMid() const
 {
   return mid;
 }
 
 template<typename T>
-double Price<T>::GetBidOfferSpread() const
+TickPrice Price<T>::GetBidOfferSpread() const
 {
   return bidOfferSpread;
 }
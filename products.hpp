@@ -36,9 +36,16 @@ public:
   // Ge the product type
   ProductType GetProductType() const;
 
+  // Get the dense index assigned by the product universe, -1 if not registered
+  int GetProductIndex() const;
+
+  // Set the dense index, called by the product universe on registration
+  void SetProductIndex(int _productIndex);
+
 private:
   string productId;
   ProductType productType;
+  int productIndex;
 
 };
 
@@ -84,6 +91,7 @@ Product::Product(string _productId, ProductType _productType)
 {
   productId = _productId;
   productType = _productType;
+  productIndex = -1;
 }
 
 const string& Product::GetProductId() const
@@ -96,6 +104,16 @@ ProductType Product::GetProductType() const
   return productType;
 }
 
+int Product::GetProductIndex() const
+{
+  return productIndex;
+}
+
+void Product::SetProductIndex(int _productIndex)
+{
+  productIndex = _productIndex;
+}
+
 Bond::Bond(string _productId, BondIdType _bondIdType, string _ticker, float _coupon, string _maturityDate) : Product(_productId, BOND)
 {
   bondIdType = _bondIdType;
@@ -26,6 +26,9 @@ public:
   // Get the product on this PV01 value
   const T& GetProduct() const;
 
+  // Get the dense index of the product
+  int GetProductIndex() const;
+
   // Get the PV01 value
   double GetPV01() const;
 
@@ -35,7 +38,8 @@ public:
   void SetQuantity(const long& qty);
 
 private:
-  T product;
+  const T* product;
+  int productIndex;
   double pv01;
   long quantity;
 
@@ -61,6 +65,9 @@ public:
   // Get the name of the bucket
   const string& GetName() const;
 
+  // Sectors are not registered in the product universe, always -1
+  int GetProductIndex() const;
+
 private:
   vector<T> products;
   string name;
@@ -88,15 +95,22 @@ public:
 
 template<typename T>
 PV01<T>::PV01(const T &_product, double _pv01, long _quantity) :
-  product(_product)
+  product(&_product)
 {
+  productIndex = _product.GetProductIndex();
   pv01 = _pv01;
   quantity = _quantity;
 }
 
 template<typename T>
 const T& PV01<T>::GetProduct() const {
-	return product;
+	return *product;
+}
+
+template<typename T>
+int PV01<T>::GetProductIndex() const
+{
+  return productIndex;
 }
 
 template<typename T>
@@ -133,4 +147,10 @@ const string& BucketedSector<T>::GetName() const
   return name;
 }
 
+template<typename T>
+int BucketedSector<T>::GetProductIndex() const
+{
+  return -1;
+}
+
 #endif
@@ -0,0 +1,430 @@
+/**
+ * sharedstate.hpp
+ * Latest price and position per product mirrored into a POSIX shared memory segment, and
+ * the reader other local processes map it with. Reads are plain loads from the mapping,
+ * with no system call after the segment is opened.
+ *
+ */
+#ifndef SHARED_STATE_HPP
+#define SHARED_STATE_HPP
+
+#include <atomic>
+#include <algorithm>
+#include <new>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pricetable.hpp"
+#include "products.hpp"
+#include "stringview.hpp"
+
+using namespace std;
+
+//Bytes stored per product id, room for a 12 character ISIN or 9 character CUSIP rounded up
+//so each id starts on a 16 byte boundary. Longer ids are truncated, shorter ones NUL padded.
+const int SHARED_STATE_ID_SIZE = 16;
+
+const uint32_t SHARED_STATE_VERSION = 2;
+
+const char SHARED_STATE_MAGIC[8] = { 'T', 'S', 'S', 'T', 'A', 'T', 'E', '\0' };
+
+//Aggregate position of one product behind a sequence lock, like PriceSlot
+struct alignas(CACHE_LINE_SIZE) PositionSlot
+{
+	SeqLock lock;
+	atomic<long long> position;
+
+	PositionSlot();
+};
+
+static_assert(sizeof(PositionSlot) == CACHE_LINE_SIZE, "PositionSlot must fill one cache line");
+
+//Atomics shared between processes must not fall back to a lock held in one process's memory
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "shared state atomics must always be lock free");
+
+/**
+ * Aggregate position per dense product index, written by one thread and read by any, the
+ * way PriceTable holds prices. Views slots it doesn't own.
+ */
+class PositionTable
+{
+private:
+
+	PositionSlot* slots;
+	size_t count;
+
+public:
+
+	PositionTable(PositionSlot* slots_, size_t products);
+
+	// Number of product slots
+	size_t Capacity() const;
+
+	// Writer side: publish a product's aggregate position, false if the index is outside the table
+	bool Publish(int productIndex, long long position);
+
+	// Any thread: copy out the latest position, false if none has been published
+	bool Read(int productIndex, long long& position, unsigned int* updates = NULL) const;
+
+};
+
+/**
+ * Leads the segment. Product ids, then the price slots, then the position slots follow at
+ * the offsets given, each on a 64 byte boundary. ready is set last, once the rest is laid out.
+ */
+struct SharedStateHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t product_count;
+	uint32_t price_slot_size;
+	uint32_t position_slot_size;
+	uint64_t ids_offset;
+	uint64_t prices_offset;
+	uint64_t positions_offset;
+	uint64_t size;
+	atomic<uint32_t> ready;
+};
+
+/**
+ * Creates the segment for a universe and owns its mapping. An existing segment of the same
+ * name is unlinked first, so readers still mapping it keep the old state and new readers
+ * get this one. The segment outlives the process for tools to read the final state,
+ * Remove unlinks it.
+ */
+class SharedStateWriter
+{
+private:
+
+	char* base;
+	size_t size;
+
+	PriceTable* prices;
+	PositionTable* positions;
+
+	SharedStateWriter(const SharedStateWriter&);
+	SharedStateWriter& operator=(const SharedStateWriter&);
+
+public:
+
+	// name must start with a '/', as shm_open requires
+	SharedStateWriter(const string& name, const vector<Bond>& universe);
+
+	~SharedStateWriter();
+
+	// Whether the segment was created and mapped
+	bool IsOpen() const;
+
+	// Tables to hand the pricing and position services, each must have one writing thread.
+	// NULL unless the segment is open.
+	PriceTable* Prices();
+	PositionTable* Positions();
+
+	static void Remove(const string& name);
+
+};
+
+/**
+ * Maps a segment read-only. A missing segment, or one not yet ready, with a different
+ * layout version or slot sizes, or whose regions don't lie within it, reads as closed with
+ * no products.
+ */
+class SharedStateReader
+{
+private:
+
+	const char* base;
+	size_t size;
+	size_t product_count;
+
+	PriceTable* prices;
+	PositionTable* positions;
+
+	SharedStateReader(const SharedStateReader&);
+	SharedStateReader& operator=(const SharedStateReader&);
+
+public:
+
+	SharedStateReader(const string& name);
+
+	~SharedStateReader();
+
+	bool IsOpen() const;
+
+	size_t ProductCount() const;
+
+	// Product id of a product index, empty if the index is outside the segment
+	StringView ProductId(int productIndex) const;
+
+	// Product index of a product id, -1 if it is not in the segment. Scans the ids.
+	int FindProduct(StringView productId) const;
+
+	// Copy out the latest price or position, false if none has been published
+	bool ReadPrice(int productIndex, TickPrice& mid, TickPrice& spread, unsigned int* updates = NULL) const;
+	bool ReadPosition(int productIndex, long long& position, unsigned int* updates = NULL) const;
+
+};
+
+//Offset rounded up to the next 64 byte boundary
+size_t shared_state_align(size_t offset) {
+	return (offset + 63) & ~(size_t) 63;
+}
+
+//Whether count items of item_size from a 64 byte aligned offset lie within size bytes
+bool shared_state_fits(uint64_t offset, uint64_t count, uint64_t item_size, uint64_t size) {
+	return offset % 64 == 0 && offset <= size && count <= (size - offset) / item_size;
+}
+
+PositionSlot::PositionSlot() : position(0) {}
+
+PositionTable::PositionTable(PositionSlot* slots_, size_t products) {
+	slots = slots_;
+	count = products;
+}
+
+size_t PositionTable::Capacity() const {
+	return count;
+}
+
+bool PositionTable::Publish(int productIndex, long long position) {
+
+	if (productIndex < 0 || productIndex >= (int) count) {
+		return false;
+	}
+
+	PositionSlot& slot = slots[productIndex];
+
+	slot.lock.BeginWrite();
+	slot.position.store(position, memory_order_relaxed);
+	slot.lock.EndWrite();
+
+	return true;
+}
+
+bool PositionTable::Read(int productIndex, long long& position, unsigned int* updates) const {
+
+	if (productIndex < 0 || productIndex >= (int) count) {
+		return false;
+	}
+
+	const PositionSlot& slot = slots[productIndex];
+	unsigned int before;
+	long long value;
+
+	do {
+		before = slot.lock.BeginRead();
+		value = slot.position.load(memory_order_relaxed);
+	} while (slot.lock.RetryRead(before));
+
+	if (updates != NULL) {
+		*updates = before / 2;
+	}
+
+	if (before == 0) {
+		return false;
+	}
+
+	position = value;
+	return true;
+}
+
+SharedStateWriter::SharedStateWriter(const string& name, const vector<Bond>& universe) {
+
+	base = NULL;
+	size = 0;
+	prices = NULL;
+	positions = NULL;
+
+	size_t n = universe.size();
+	size_t ids_offset = shared_state_align(sizeof(SharedStateHeader));
+	size_t prices_offset = shared_state_align(ids_offset + n * SHARED_STATE_ID_SIZE);
+	size_t positions_offset = prices_offset + n * sizeof(PriceSlot);
+	size_t total = positions_offset + n * sizeof(PositionSlot);
+
+	shm_unlink(name.c_str());
+
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+
+	if (fd < 0) {
+		return;
+	}
+
+	void* p = MAP_FAILED;
+
+	if (ftruncate(fd, (off_t) total) == 0) {
+		p = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+
+	close(fd);
+
+	if (p == MAP_FAILED) {
+		shm_unlink(name.c_str());
+		return;
+	}
+
+	base = (char*) p;
+	size = total;
+
+	SharedStateHeader* header = new (base) SharedStateHeader();
+	memcpy(header->magic, SHARED_STATE_MAGIC, sizeof(header->magic));
+	header->version = SHARED_STATE_VERSION;
+	header->product_count = (uint32_t) n;
+	header->price_slot_size = sizeof(PriceSlot);
+	header->position_slot_size = sizeof(PositionSlot);
+	header->ids_offset = ids_offset;
+	header->prices_offset = prices_offset;
+	header->positions_offset = positions_offset;
+	header->size = total;
+
+	for (size_t i = 0; i < n; i++) {
+		const string& id = universe[i].GetProductId();
+		memcpy(base + ids_offset + i * SHARED_STATE_ID_SIZE, id.data(), min(id.size(), (size_t) SHARED_STATE_ID_SIZE));
+	}
+
+	PriceSlot* price_slots = (PriceSlot*) (base + prices_offset);
+	PositionSlot* position_slots = (PositionSlot*) (base + positions_offset);
+
+	for (size_t i = 0; i < n; i++) {
+		new (&price_slots[i]) PriceSlot();
+		new (&position_slots[i]) PositionSlot();
+	}
+
+	prices = new PriceTable(price_slots, n);
+	positions = new PositionTable(position_slots, n);
+
+	header->ready.store(1, memory_order_release);
+}
+
+SharedStateWriter::~SharedStateWriter() {
+
+	delete prices;
+	delete positions;
+
+	if (base != NULL) {
+		munmap(base, size);
+	}
+}
+
+bool SharedStateWriter::IsOpen() const {
+	return base != NULL;
+}
+
+PriceTable* SharedStateWriter::Prices() {
+	return prices;
+}
+
+PositionTable* SharedStateWriter::Positions() {
+	return positions;
+}
+
+void SharedStateWriter::Remove(const string& name) {
+	shm_unlink(name.c_str());
+}
+
+SharedStateReader::SharedStateReader(const string& name) {
+
+	base = NULL;
+	size = 0;
+	product_count = 0;
+	prices = NULL;
+	positions = NULL;
+
+	int fd = shm_open(name.c_str(), O_RDONLY, 0);
+
+	if (fd < 0) {
+		return;
+	}
+
+	struct stat st;
+	void* p = MAP_FAILED;
+
+	if (fstat(fd, &st) == 0 && (size_t) st.st_size >= sizeof(SharedStateHeader)) {
+		p = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	}
+
+	close(fd);
+
+	if (p == MAP_FAILED) {
+		return;
+	}
+
+	const SharedStateHeader* header = (const SharedStateHeader*) p;
+
+	if (header->ready.load(memory_order_acquire) != 1
+		|| memcmp(header->magic, SHARED_STATE_MAGIC, sizeof(header->magic)) != 0
+		|| header->version != SHARED_STATE_VERSION
+		|| header->price_slot_size != sizeof(PriceSlot)
+		|| header->position_slot_size != sizeof(PositionSlot)
+		|| header->size > (uint64_t) st.st_size
+		|| !shared_state_fits(header->ids_offset, header->product_count, SHARED_STATE_ID_SIZE, header->size)
+		|| !shared_state_fits(header->prices_offset, header->product_count, sizeof(PriceSlot), header->size)
+		|| !shared_state_fits(header->positions_offset, header->product_count, sizeof(PositionSlot), header->size)) {
+		munmap(p, (size_t) st.st_size);
+		return;
+	}
+
+	base = (const char*) p;
+	size = (size_t) st.st_size;
+	product_count = header->product_count;
+
+	//Tables are only read through, the mapping itself is read-only
+	prices = new PriceTable((PriceSlot*) (base + header->prices_offset), product_count);
+	positions = new PositionTable((PositionSlot*) (base + header->positions_offset), product_count);
+}
+
+SharedStateReader::~SharedStateReader() {
+
+	delete prices;
+	delete positions;
+
+	if (base != NULL) {
+		munmap((void*) base, size);
+	}
+}
+
+bool SharedStateReader::IsOpen() const {
+	return base != NULL;
+}
+
+size_t SharedStateReader::ProductCount() const {
+	return product_count;
+}
+
+StringView SharedStateReader::ProductId(int productIndex) const {
+
+	if (productIndex < 0 || productIndex >= (int) product_count) {
+		return StringView();
+	}
+
+	const SharedStateHeader* header = (const SharedStateHeader*) base;
+	const char* id = base + header->ids_offset + productIndex * SHARED_STATE_ID_SIZE;
+	const char* nul = (const char*) memchr(id, '\0', SHARED_STATE_ID_SIZE);
+
+	return StringView(id, nul == NULL ? SHARED_STATE_ID_SIZE : nul - id);
+}
+
+int SharedStateReader::FindProduct(StringView productId) const {
+
+	for (size_t i = 0; i < product_count; i++) {
+		if (ProductId((int) i) == productId) {
+			return (int) i;
+		}
+	}
+
+	return -1;
+}
+
+bool SharedStateReader::ReadPrice(int productIndex, TickPrice& mid, TickPrice& spread, unsigned int* updates) const {
+	return prices != NULL && prices->Read(productIndex, mid, spread, updates);
+}
+
+bool SharedStateReader::ReadPosition(int productIndex, long long& position, unsigned int* updates) const {
+	return positions != NULL && positions->Read(productIndex, position, updates);
+}
+
+#endif
@@ -26,6 +26,10 @@ public:
   // Listener callback to process an add event to the Service
   virtual void ProcessAdd(V &data) = 0;
 
+  // Listener callback to process count consecutive add events to the Service.
+  // Defaults to ProcessAdd on each, listeners override it to amortize work across the batch.
+  virtual void ProcessAddBatch(V *data, size_t count);
+
   // Listener callback to process a remove event to the Service
   virtual void ProcessRemove(V &data) = 0;
 
@@ -50,6 +54,10 @@ public:
   // The callback that a Connector should invoke for any new or updated data
   virtual void OnMessage(V &data) = 0;
 
+  // The callback for count consecutive new or updated data.
+  // Defaults to OnMessage on each, Services override it to amortize work across the batch.
+  virtual void OnMessageBatch(V *data, size_t count);
+
   // Add a listener to the Service for callbacks on add, remove, and update events
   // for data to the Service.
   virtual void AddListener(ServiceListener<V> *listener) = 0;
@@ -59,6 +67,75 @@ public:
 
 };  
 
+/**
+ * Listener set wired at runtime: a list of ServiceListener pointers called through
+ * their virtual ProcessAdd/ProcessRemove/ProcessUpdate. This is how Services dispatch
+ * to their listeners by default.
+ */
+template<typename V>
+class DynamicListeners
+{
+
+public:
+
+  // Add a listener to the set
+  void Add(ServiceListener<V> *listener);
+
+  // Get all listeners in the set
+  const vector< ServiceListener<V>* >& Get() const;
+
+  // Notify every listener of an add, remove, or update event
+  void ProcessAdd(V &data);
+  void ProcessRemove(V &data);
+  void ProcessUpdate(V &data);
+
+  // Hand a batch of add events to each listener in turn
+  void ProcessAddBatch(V *data, size_t count);
+
+private:
+  vector< ServiceListener<V>* > listeners;
+
+};
+
+/**
+ * Listener set fixed at compile time for a fully known pipeline.
+ * Each listener is called through a qualified call on its concrete type, so there is no
+ * virtual dispatch and the whole chain can be inlined when the downstream services are
+ * statically wired as well. Listener types only need ProcessAdd/ProcessRemove/ProcessUpdate,
+ * they do not have to derive from ServiceListener.
+ */
+template<typename V, typename... Ls>
+class StaticListeners;
+
+// End of a static set. Listeners added at runtime are kept here and notified after the
+// static ones, so AddListener on a statically wired Service still delivers every event.
+// Get returns only these, static listeners are not ServiceListener pointers.
+template<typename V>
+class StaticListeners<V> : public DynamicListeners<V>
+{
+};
+
+template<typename V, typename L, typename... Ls>
+class StaticListeners<V, L, Ls...> : public StaticListeners<V, Ls...>
+{
+
+public:
+
+  // ctor taking the listeners in the order they are notified
+  StaticListeners(L *_listener, Ls*... _rest);
+
+  void ProcessAdd(V &data);
+  void ProcessRemove(V &data);
+  void ProcessUpdate(V &data);
+
+  // Each listener sees the whole batch through its inlined ProcessAdd before the next one
+  void ProcessAddBatch(V *data, size_t count);
+
+private:
+  L *listener;
+
+};
+
 /**
  * Definition of a Connector class.
  * This will invoke the Service.OnMessage() method for subscriber Connectors
@@ -78,4 +155,100 @@ public:
 
 };
 
+template<typename V>
+void ServiceListener<V>::ProcessAddBatch(V *data, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    ProcessAdd(data[i]);
+  }
+}
+
+template<typename K, typename V>
+void Service<K, V>::OnMessageBatch(V *data, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    OnMessage(data[i]);
+  }
+}
+
+template<typename V>
+void DynamicListeners<V>::Add(ServiceListener<V> *listener)
+{
+  listeners.push_back(listener);
+}
+
+template<typename V>
+const vector< ServiceListener<V>* >& DynamicListeners<V>::Get() const
+{
+  return listeners;
+}
+
+template<typename V>
+void DynamicListeners<V>::ProcessAdd(V &data)
+{
+  for (int i = 0; i < listeners.size(); i++) {
+    listeners[i]->ProcessAdd(data);
+  }
+}
+
+template<typename V>
+void DynamicListeners<V>::ProcessRemove(V &data)
+{
+  for (int i = 0; i < listeners.size(); i++) {
+    listeners[i]->ProcessRemove(data);
+  }
+}
+
+template<typename V>
+void DynamicListeners<V>::ProcessUpdate(V &data)
+{
+  for (int i = 0; i < listeners.size(); i++) {
+    listeners[i]->ProcessUpdate(data);
+  }
+}
+
+template<typename V>
+void DynamicListeners<V>::ProcessAddBatch(V *data, size_t count)
+{
+  for (int i = 0; i < listeners.size(); i++) {
+    listeners[i]->ProcessAddBatch(data, count);
+  }
+}
+
+template<typename V, typename L, typename... Ls>
+StaticListeners<V, L, Ls...>::StaticListeners(L *_listener, Ls*... _rest) :
+  StaticListeners<V, Ls...>(_rest...), listener(_listener)
+{
+}
+
+template<typename V, typename L, typename... Ls>
+void StaticListeners<V, L, Ls...>::ProcessAdd(V &data)
+{
+  listener->L::ProcessAdd(data);
+  StaticListeners<V, Ls...>::ProcessAdd(data);
+}
+
+template<typename V, typename L, typename... Ls>
+void StaticListeners<V, L, Ls...>::ProcessRemove(V &data)
+{
+  listener->L::ProcessRemove(data);
+  StaticListeners<V, Ls...>::ProcessRemove(data);
+}
+
+template<typename V, typename L, typename... Ls>
+void StaticListeners<V, L, Ls...>::ProcessUpdate(V &data)
+{
+  listener->L::ProcessUpdate(data);
+  StaticListeners<V, Ls...>::ProcessUpdate(data);
+}
+
+template<typename V, typename L, typename... Ls>
+void StaticListeners<V, L, Ls...>::ProcessAddBatch(V *data, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    listener->L::ProcessAdd(data[i]);
+  }
+  StaticListeners<V, Ls...>::ProcessAddBatch(data, count);
+}
+
 #endif
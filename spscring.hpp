@@ -0,0 +1,141 @@
+/**
+ * spscring.hpp
+ * Bounded lock-free ring buffer for handing events from exactly one producer thread
+ * to exactly one consumer thread.
+ *
+ */
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+/**
+ * Single-producer/single-consumer ring. The producer only writes tail and the consumer
+ * only writes head, so each side needs one acquire load of the other's index, and each
+ * side caches that index so most operations touch no shared cache line at all.
+ * Elements are constructed in place on push and read in place by the consumer, so T only
+ * needs to be copy constructible. Capacity is rounded up to a power of two.
+ */
+template<typename T>
+class SpscRing
+{
+private:
+
+	//Raw storage, a slot only holds a live T between TryPush and Pop
+	typedef typename aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+	vector<Slot> slots;
+	size_t mask;
+
+	//Padding keeps each side's index on its own cache line so the two threads don't false share
+	char pad0[64];
+	atomic<size_t> head;
+	size_t cached_tail;
+
+	char pad1[64];
+	atomic<size_t> tail;
+	size_t cached_head;
+
+	char pad2[64];
+
+public:
+
+	SpscRing(size_t capacity);
+
+	~SpscRing();
+
+	// Producer side: copy value in, false if the ring is full
+	bool TryPush(const T& value);
+
+	// Consumer side: oldest value, NULL if the ring is empty
+	T* Front();
+
+	// Consumer side: release the value returned by Front
+	void Pop();
+
+	// Consumer side: whether there is nothing left to pop
+	bool Empty() const;
+
+	size_t Capacity() const;
+
+};
+
+template<typename T>
+SpscRing<T>::SpscRing(size_t capacity) : head(0), tail(0) {
+
+	size_t size = 2;
+	while (size < capacity) {
+		size *= 2;
+	}
+
+	slots.resize(size);
+	mask = size - 1;
+	cached_tail = 0;
+	cached_head = 0;
+}
+
+template<typename T>
+SpscRing<T>::~SpscRing() {
+	while (Front() != NULL) {
+		Pop();
+	}
+}
+
+template<typename T>
+bool SpscRing<T>::TryPush(const T& value) {
+
+	size_t t = tail.load(memory_order_relaxed);
+
+	if (t - cached_head > mask) {
+		cached_head = head.load(memory_order_acquire);
+		if (t - cached_head > mask) {
+			return false;
+		}
+	}
+
+	new (&slots[t & mask]) T(value);
+	tail.store(t + 1, memory_order_release);
+	return true;
+}
+
+template<typename T>
+T* SpscRing<T>::Front() {
+
+	size_t h = head.load(memory_order_relaxed);
+
+	if (h == cached_tail) {
+		cached_tail = tail.load(memory_order_acquire);
+		if (h == cached_tail) {
+			return NULL;
+		}
+	}
+
+	return reinterpret_cast<T*>(&slots[h & mask]);
+}
+
+template<typename T>
+void SpscRing<T>::Pop() {
+
+	size_t h = head.load(memory_order_relaxed);
+
+	reinterpret_cast<T*>(&slots[h & mask])->~T();
+	head.store(h + 1, memory_order_release);
+}
+
+template<typename T>
+bool SpscRing<T>::Empty() const {
+	return head.load(memory_order_relaxed) == tail.load(memory_order_acquire);
+}
+
+template<typename T>
+size_t SpscRing<T>::Capacity() const {
+	return slots.size();
+}
+
+#endif
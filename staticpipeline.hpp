@@ -0,0 +1,145 @@
+/**
+ * staticpipeline.hpp
+ * Compile-time wiring of the market data and trade booking chains, built on StaticListeners.
+ * Every service in the chain knows the concrete type of its listeners and every listener knows
+ * the concrete type of the service it feeds, so a market data update runs through
+ * MarketData -> AlgoExecution -> Execution -> Historical and a booked trade through
+ * TradeBooking -> Position -> Risk -> Historical as direct calls the compiler can inline.
+ *
+ */
+#ifndef STATIC_PIPELINE_HPP
+#define STATIC_PIPELINE_HPP
+
+#include "bonduniverseservice.hpp"
+#include "bondmarketdataservice.hpp"
+#include "bondtradebookingservice.hpp"
+#include "bondpositionservice.hpp"
+#include "bondriskservice.hpp"
+#include "bondalgoexecutionservice.hpp"
+#include "bondexecutionservice.hpp"
+#include "bondhistoricaldataservice.hpp"
+
+//Types are declared from the end of each chain backwards since each listener names the service it feeds
+typedef BasicBondRiskService<StaticListeners<PV01<Bond>, ServiceListenerToHistorical<PV01<Bond> > > > StaticBondRiskService;
+
+typedef BasicBondPositionServiceListener<StaticBondRiskService> StaticBondPositionServiceListener;
+typedef BasicBondPositionService<StaticListeners<Position<Bond>, StaticBondPositionServiceListener, ServiceListenerToHistorical<Position<Bond> > > > StaticBondPositionService;
+
+typedef BasicBondTradeBookingServiceListener<StaticBondPositionService> StaticBondTradeBookingServiceListener;
+typedef BasicBondTradeBookingService<StaticListeners<Trade<Bond>, StaticBondTradeBookingServiceListener> > StaticBondTradeBookingService;
+
+typedef BasicBondExecutionService<StaticListeners<ExecutionOrder<Bond>, ServiceListenerToHistorical<ExecutionOrder<Bond> > > > StaticBondExecutionService;
+
+typedef BasicBondAlgoExecutionServiceListener<StaticBondExecutionService> StaticBondAlgoExecutionServiceListener;
+typedef BasicBondAlgoExecutionService<StaticListeners<AlgoExecution<Bond>, StaticBondAlgoExecutionServiceListener> > StaticBondAlgoExecutionService;
+
+typedef BasicBondMarketDataServiceListener<StaticBondAlgoExecutionService> StaticBondMarketDataServiceListener;
+typedef BasicBondMarketDataService<StaticListeners<OrderBook<Bond>, StaticBondMarketDataServiceListener> > StaticBondMarketDataService;
+
+/**
+ * Owns every service, listener and connector of the two chains, wired the same way main.cpp
+ * wires them at runtime. Members are declared in construction order, persistence first.
+ */
+class StaticExecutionPipeline
+{
+private:
+
+	BondHistoricalDataConnector<ExecutionOrder<Bond> > historical_exe_connector;
+	BondHistoricalDataConnector<Position<Bond> > historical_pos_connector;
+	BondHistoricalDataConnector<PV01<Bond> > historical_pv_connector;
+
+	BondHistoricalDataService<ExecutionOrder<Bond> > historical_exe_service;
+	BondHistoricalDataService<Position<Bond> > historical_pos_service;
+	BondHistoricalDataService<PV01<Bond> > historical_pv_service;
+
+	ServiceListenerToHistorical<ExecutionOrder<Bond> > exe_listener_historical;
+	ServiceListenerToHistorical<Position<Bond> > pos_listener_historical;
+	ServiceListenerToHistorical<PV01<Bond> > pv_listener_historical;
+
+	StaticBondRiskService risk_service;
+	StaticBondPositionServiceListener pos_listener;
+	StaticBondPositionService pos_service;
+	StaticBondTradeBookingServiceListener trade_book_listener;
+	StaticBondTradeBookingService btb_service;
+
+	BondExecutionConnector exec_connector;
+	StaticBondExecutionService exec_service;
+	StaticBondAlgoExecutionServiceListener algo_exec_listener;
+	StaticBondAlgoExecutionService algo_exec_service;
+	StaticBondMarketDataServiceListener md_listener;
+	StaticBondMarketDataService md_service;
+
+	BondMarketDataConnector md_connector;
+	BondTradeBookingConnector btb_connector;
+
+public:
+
+	StaticExecutionPipeline(BondUniverseService*);
+
+	// Subscribe to marketdata.txt
+	void SubscribeMarketData();
+
+	// Get the market data connector, to subscribe in one of its other modes
+	BondMarketDataConnector& GetMarketDataConnector();
+
+	// Get the market data service, to snapshot its books
+	StaticBondMarketDataService& GetMarketDataService();
+
+	// Get the position service, to mirror its positions
+	StaticBondPositionService& GetPositionService();
+
+	// Subscribe to trades.txt
+	void SubscribeTrades();
+
+};
+
+StaticExecutionPipeline::StaticExecutionPipeline(BondUniverseService* uni_service) :
+	historical_exe_service(&historical_exe_connector),
+	historical_pos_service(&historical_pos_connector),
+	historical_pv_service(&historical_pv_connector),
+	exe_listener_historical(&historical_exe_service),
+	pos_listener_historical(&historical_pos_service),
+	pv_listener_historical(&historical_pv_service),
+	risk_service(StaticListeners<PV01<Bond>, ServiceListenerToHistorical<PV01<Bond> > >(&pv_listener_historical)),
+	pos_listener(&risk_service),
+	pos_service(StaticListeners<Position<Bond>, StaticBondPositionServiceListener, ServiceListenerToHistorical<Position<Bond> > >(&pos_listener, &pos_listener_historical)),
+	trade_book_listener(&pos_service),
+	btb_service(StaticListeners<Trade<Bond>, StaticBondTradeBookingServiceListener>(&trade_book_listener)),
+	exec_service(&exec_connector, StaticListeners<ExecutionOrder<Bond>, ServiceListenerToHistorical<ExecutionOrder<Bond> > >(&exe_listener_historical)),
+	algo_exec_listener(&exec_service),
+	algo_exec_service(StaticListeners<AlgoExecution<Bond>, StaticBondAlgoExecutionServiceListener>(&algo_exec_listener)),
+	md_listener(&algo_exec_service),
+	md_service(StaticListeners<OrderBook<Bond>, StaticBondMarketDataServiceListener>(&md_listener)),
+	md_connector(&md_service, uni_service),
+	btb_connector(&btb_service, uni_service)
+{
+	historical_exe_connector.setBondService(&historical_exe_service);
+	historical_pos_connector.setBondService(&historical_pos_service);
+	historical_pv_connector.setBondService(&historical_pv_service);
+	exec_connector.setBondExecutionService(&exec_service);
+
+	//The chain runs on the connector's thread, so the algo can read consolidated books directly
+	md_listener.RouteByVenue(&md_service.GetConsolidatedBooks());
+}
+
+void StaticExecutionPipeline::SubscribeMarketData() {
+	md_connector.Subscribe();
+}
+
+BondMarketDataConnector& StaticExecutionPipeline::GetMarketDataConnector() {
+	return md_connector;
+}
+
+StaticBondMarketDataService& StaticExecutionPipeline::GetMarketDataService() {
+	return md_service;
+}
+
+StaticBondPositionService& StaticExecutionPipeline::GetPositionService() {
+	return pos_service;
+}
+
+void StaticExecutionPipeline::SubscribeTrades() {
+	btb_connector.Subscribe();
+}
+
+#endif
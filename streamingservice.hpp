@@ -8,6 +8,7 @@
 #define STREAMING_SERVICE_HPP
 
 #include "soa.hpp"
+#include "tickprice.hpp"
 #include "marketdataservice.hpp"
 
 /**
@@ -21,13 +22,13 @@ public:
   PriceStreamOrder();
 
   // ctor for an order
-  PriceStreamOrder(double _price, long _visibleQuantity, long _hiddenQuantity, PricingSide _side);
+  PriceStreamOrder(TickPrice _price, long _visibleQuantity, long _hiddenQuantity, PricingSide _side);
 
   // The side on this order
   PricingSide GetSide() const;
 
   // Get the price on this order
-  double GetPrice() const;
+  TickPrice GetPrice() const;
 
   // Get the visible quantity on this order
   long GetVisibleQuantity() const;
@@ -36,10 +37,10 @@ public:
   long GetHiddenQuantity() const;
 
 private:
-  double price;
+  TickPrice price;
+  PricingSide side;
   long visibleQuantity;
   long hiddenQuantity;
-  PricingSide side;
 
 };
 
@@ -61,6 +62,9 @@ public:
   // Get the product
   const T& GetProduct() const;
 
+  // Get the dense index of the product
+  int GetProductIndex() const;
+
   // Get the bid order
   const PriceStreamOrder& GetBidOrder() const;
 
@@ -68,7 +72,8 @@ public:
   const PriceStreamOrder& GetOfferOrder() const;
 
 private:
-  T product;
+  const T* product;
+  int productIndex;
   PriceStreamOrder bidOrder;
   PriceStreamOrder offerOrder;
 
@@ -92,7 +97,7 @@ public:
 
 PriceStreamOrder::PriceStreamOrder() {}
 
-PriceStreamOrder::PriceStreamOrder(double _price, long _visibleQuantity, long _hiddenQuantity, PricingSide _side)
+PriceStreamOrder::PriceStreamOrder(TickPrice _price, long _visibleQuantity, long _hiddenQuantity, PricingSide _side)
 {
   price = _price;
   visibleQuantity = _visibleQuantity;
@@ -100,7 +105,7 @@ PriceStreamOrder::PriceStreamOrder(double _price, long _visibleQuantity, long _h
   side = _side;
 }
 
-double PriceStreamOrder::GetPrice() const
+TickPrice PriceStreamOrder::GetPrice() const
 {
   return price;
 }
@@ -116,18 +121,28 @@ long PriceStreamOrder::GetHiddenQuantity() const
 }
 
 template<typename T>
-PriceStream<T>::PriceStream() {}
+PriceStream<T>::PriceStream() {
+  product = NULL;
+  productIndex = -1;
+}
 
 template<typename T>
 PriceStream<T>::PriceStream(const T &_product, const PriceStreamOrder &_bidOrder, const PriceStreamOrder &_offerOrder) :
-  product(_product), bidOrder(_bidOrder), offerOrder(_offerOrder)
+  product(&_product), bidOrder(_bidOrder), offerOrder(_offerOrder)
 {
+  productIndex = _product.GetProductIndex();
 }
 
 template<typename T>
 const T& PriceStream<T>::GetProduct() const
 {
-  return product;
+  return *product;
+}
+
+template<typename T>
+int PriceStream<T>::GetProductIndex() const
+{
+  return productIndex;
 }
 
 template<typename T>
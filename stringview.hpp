@@ -0,0 +1,106 @@
+/**
+ * stringview.hpp
+ * Non-owning view of a run of characters, used to parse input files in place.
+ *
+ */
+#ifndef STRING_VIEW_HPP
+#define STRING_VIEW_HPP
+
+#include <string>
+#include <cstring>
+
+using namespace std;
+
+/**
+ * Pointer and length into a buffer owned by someone else, typically a MappedFile.
+ * A view is only valid while that buffer is.
+ */
+class StringView
+{
+private:
+
+	const char* ptr;
+	size_t len;
+
+public:
+
+	StringView();
+
+	StringView(const char* ptr_, size_t len_);
+
+	StringView(const string& s);
+
+	const char* data() const;
+
+	size_t size() const;
+
+	bool empty() const;
+
+	char operator[](size_t i) const;
+
+	// Copy the characters out into an owning string
+	string str() const;
+
+	bool operator==(const StringView& other) const;
+
+	bool operator!=(const StringView& other) const;
+
+	// Compare against a nul-terminated literal without building a string
+	bool operator==(const char* other) const;
+
+	bool operator!=(const char* other) const;
+
+};
+
+StringView::StringView() {
+	ptr = "";
+	len = 0;
+}
+
+StringView::StringView(const char* ptr_, size_t len_) {
+	ptr = ptr_;
+	len = len_;
+}
+
+StringView::StringView(const string& s) {
+	ptr = s.data();
+	len = s.size();
+}
+
+const char* StringView::data() const {
+	return ptr;
+}
+
+size_t StringView::size() const {
+	return len;
+}
+
+bool StringView::empty() const {
+	return len == 0;
+}
+
+char StringView::operator[](size_t i) const {
+	return ptr[i];
+}
+
+string StringView::str() const {
+	return string(ptr, len);
+}
+
+bool StringView::operator==(const StringView& other) const {
+	return len == other.len && memcmp(ptr, other.ptr, len) == 0;
+}
+
+bool StringView::operator!=(const StringView& other) const {
+	return !(*this == other);
+}
+
+bool StringView::operator==(const char* other) const {
+	return strlen(other) == len && memcmp(ptr, other, len) == 0;
+}
+
+bool StringView::operator!=(const char* other) const {
+	return !(*this == other);
+}
+
+#endif
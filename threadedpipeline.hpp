@@ -0,0 +1,243 @@
+/**
+ * threadedpipeline.hpp
+ * Decouples a listener from the Service that notifies it, so that everything downstream
+ * of the listener runs on its own thread, fed through an SpscRing.
+ *
+ */
+#ifndef THREADED_PIPELINE_HPP
+#define THREADED_PIPELINE_HPP
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "soa.hpp"
+#include "spscring.hpp"
+#include "pipelinestage.hpp"
+#include "conflatinglistener.hpp"
+
+using namespace std;
+
+/**
+ * Listener that queues each event it receives and replays it into the wrapped listener on a
+ * dedicated consumer thread. Events are copied into the ring, so the Service notifying this
+ * listener may reuse its data as soon as the call returns.
+ * Only one thread may notify a given AsyncListener, and the wrapped listener (and whatever it
+ * feeds) must not be touched by any other thread while the stage is running.
+ */
+template<typename V>
+class AsyncListener : public ServiceListener<V>, public PipelineStage
+{
+
+private:
+
+	enum EventType { ADD, REMOVE, UPDATE };
+
+	struct Event
+	{
+		EventType type;
+		V data;
+
+		Event(EventType type_, const V& data_) : type(type_), data(data_) {}
+	};
+
+	ServiceListener<V>* target;
+	SpscRing<Event> ring;
+	atomic<bool> stopping;
+	thread consumer;
+
+	// Producer side: spin until the consumer frees a slot
+	void Push(EventType type, V& data);
+
+	// Consumer thread body
+	void Run();
+
+public:
+
+	AsyncListener(ServiceListener<V>* target_, size_t capacity, int cpu = -1);
+
+	~AsyncListener();
+
+	void ProcessAdd(V& data);
+
+	void ProcessRemove(V& data);
+
+	void ProcessUpdate(V& data);
+
+	void Stop();
+
+};
+
+template<typename V>
+AsyncListener<V>::AsyncListener(ServiceListener<V>* target_, size_t capacity, int cpu) : target(target_), ring(capacity), stopping(false) {
+	consumer = thread(&AsyncListener<V>::Run, this);
+	PinThread(consumer, cpu);
+}
+
+template<typename V>
+AsyncListener<V>::~AsyncListener() {
+	Stop();
+}
+
+template<typename V>
+void AsyncListener<V>::Push(EventType type, V& data) {
+
+	Event e(type, data);
+
+	while (!ring.TryPush(e)) {
+		this_thread::yield();
+	}
+}
+
+template<typename V>
+void AsyncListener<V>::Run() {
+
+	while (true) {
+
+		Event* e = ring.Front();
+
+		if (e != NULL) {
+			switch (e->type) {
+				case ADD: target->ProcessAdd(e->data); break;
+				case REMOVE: target->ProcessRemove(e->data); break;
+				case UPDATE: target->ProcessUpdate(e->data); break;
+			}
+			ring.Pop();
+			continue;
+		}
+
+		//The producer has finished once stopping is set, so an empty ring after that is final
+		if (stopping.load(memory_order_acquire) && ring.Empty()) {
+			return;
+		}
+
+		this_thread::yield();
+	}
+}
+
+template<typename V>
+void AsyncListener<V>::ProcessAdd(V& data) {
+	Push(ADD, data);
+}
+
+template<typename V>
+void AsyncListener<V>::ProcessRemove(V& data) {
+	Push(REMOVE, data);
+}
+
+template<typename V>
+void AsyncListener<V>::ProcessUpdate(V& data) {
+	Push(UPDATE, data);
+}
+
+template<typename V>
+void AsyncListener<V>::Stop() {
+
+	if (consumer.joinable()) {
+		stopping.store(true, memory_order_release);
+		consumer.join();
+	}
+}
+
+/**
+ * Owns the AsyncListeners of a pipeline. When disabled, Decouple hands the listener back
+ * unchanged so the same wiring runs synchronously on the connector's thread.
+ * Stages must be decoupled upstream first: Stop drains them in that order, so each stage has
+ * delivered all of its events before the stages it feeds are stopped.
+ */
+class ThreadedPipeline
+{
+
+private:
+
+	bool enabled;
+	size_t capacity;
+	bool pin;
+	int next_cpu;
+	vector<PipelineStage*> stages;
+
+	// Cpu for the next stage thread, -1 when not pinning
+	int NextCpu();
+
+public:
+
+	ThreadedPipeline(bool enabled_, size_t capacity_, bool pin_);
+
+	~ThreadedPipeline();
+
+	// Listener to register on the upstream Service in place of listener
+	template<typename V>
+	ServiceListener<V>* Decouple(ServiceListener<V>* listener);
+
+	// Like Decouple, but listener only sees the latest value per product, drained on its own thread
+	template<typename V>
+	ServiceListener<V>* Conflate(ServiceListener<V>* listener);
+
+	// Drain and join every stage, upstream first
+	void Stop();
+
+	bool IsEnabled() const;
+
+};
+
+ThreadedPipeline::ThreadedPipeline(bool enabled_, size_t capacity_, bool pin_) {
+	enabled = enabled_;
+	capacity = capacity_;
+	pin = pin_;
+
+	//Cpu 0 is left to the connector thread
+	next_cpu = 1;
+}
+
+ThreadedPipeline::~ThreadedPipeline() {
+	Stop();
+	for (size_t i = 0; i < stages.size(); i++) {
+		delete stages[i];
+	}
+}
+
+template<typename V>
+ServiceListener<V>* ThreadedPipeline::Decouple(ServiceListener<V>* listener) {
+
+	if (!enabled) {
+		return listener;
+	}
+
+	AsyncListener<V>* stage = new AsyncListener<V>(listener, capacity, NextCpu());
+	stages.push_back(stage);
+	return stage;
+}
+
+template<typename V>
+ServiceListener<V>* ThreadedPipeline::Conflate(ServiceListener<V>* listener) {
+
+	if (!enabled) {
+		return listener;
+	}
+
+	ConflatingListener<V>* stage = new ConflatingListener<V>(listener);
+	stage->Start(NextCpu());
+	stages.push_back(stage);
+	return stage;
+}
+
+int ThreadedPipeline::NextCpu() {
+
+	if (!pin) {
+		return -1;
+	}
+
+	int n_cpus = (int) thread::hardware_concurrency();
+	return n_cpus > 1 ? next_cpu++ % n_cpus : -1;
+}
+
+void ThreadedPipeline::Stop() {
+	for (size_t i = 0; i < stages.size(); i++) {
+		stages[i]->Stop();
+	}
+}
+
+bool ThreadedPipeline::IsEnabled() const {
+	return enabled;
+}
+
+#endif
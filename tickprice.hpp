@@ -0,0 +1,115 @@
+/**
+ * tickprice.hpp
+ * Fixed-point treasury price, so prices compare, add and key containers exactly
+ * instead of going through doubles and epsilons.
+ *
+ */
+#ifndef TICK_PRICE_HPP
+#define TICK_PRICE_HPP
+
+#include <ostream>
+
+/**
+ * Price held as an integer count of half ticks, 1/512 of a point.
+ * Traded prices are whole 1/256 ticks; the extra bit keeps the mid of two ticks and half
+ * a bid/offer spread exact, which is what PricingService and the streaming algo compute.
+ * Comparisons and arithmetic are single integer operations, and a 32 bit count covers
+ * prices up to four million points.
+ */
+class TickPrice
+{
+private:
+
+	int units;
+
+	constexpr explicit TickPrice(int units_) : units(units_) {}
+
+public:
+
+	//Units per 1/256 tick and per point
+	static const int UNITS_PER_TICK = 2;
+	static const int UNITS_PER_POINT = 512;
+
+	constexpr TickPrice() : units(0) {}
+
+	// Price from a count of 1/256 ticks, as produced by parse_ticks
+	static constexpr TickPrice fromTicks(int ticks) {
+		return TickPrice(ticks * UNITS_PER_TICK);
+	}
+
+	// Price from a count of half ticks
+	static constexpr TickPrice fromUnits(int units_) {
+		return TickPrice(units_);
+	}
+
+	// Price nearest to a decimal value
+	static constexpr TickPrice fromDouble(double price) {
+		return TickPrice((int) (price * UNITS_PER_POINT + (price < 0 ? -0.5 : 0.5)));
+	}
+
+	constexpr int toUnits() const {
+		return units;
+	}
+
+	// Whole 1/256 ticks, a half tick is truncated
+	constexpr int toTicks() const {
+		return units / UNITS_PER_TICK;
+	}
+
+	constexpr double toDouble() const {
+		return units / (double) UNITS_PER_POINT;
+	}
+
+	constexpr TickPrice operator+(TickPrice other) const {
+		return TickPrice(units + other.units);
+	}
+
+	constexpr TickPrice operator-(TickPrice other) const {
+		return TickPrice(units - other.units);
+	}
+
+	constexpr TickPrice operator-() const {
+		return TickPrice(-units);
+	}
+
+	constexpr TickPrice operator*(int scalar) const {
+		return TickPrice(units * scalar);
+	}
+
+	// Exact for the mids and half spreads of tick prices, truncates toward zero otherwise
+	constexpr TickPrice operator/(int divisor) const {
+		return TickPrice(units / divisor);
+	}
+
+	constexpr bool operator==(TickPrice other) const {
+		return units == other.units;
+	}
+
+	constexpr bool operator!=(TickPrice other) const {
+		return units != other.units;
+	}
+
+	constexpr bool operator<(TickPrice other) const {
+		return units < other.units;
+	}
+
+	constexpr bool operator<=(TickPrice other) const {
+		return units <= other.units;
+	}
+
+	constexpr bool operator>(TickPrice other) const {
+		return units > other.units;
+	}
+
+	constexpr bool operator>=(TickPrice other) const {
+		return units >= other.units;
+	}
+
+};
+
+//Printed in decimal, the same as the double prices were
+std::ostream& operator<<(std::ostream& os, TickPrice price) {
+	return os << price.toDouble();
+}
+
+#endif
@@ -0,0 +1,214 @@
+/**
+ * tokenizer.hpp
+ * Splits a buffer of delimited lines into fields by scanning 64 bytes at a time for
+ * delimiters and newlines with SIMD compares, then walking the resulting bitmasks.
+ *
+ */
+#ifndef TOKENIZER_HPP
+#define TOKENIZER_HPP
+
+#include <vector>
+#include <cstddef>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "stringview.hpp"
+#include "mappedfile.hpp"
+
+using namespace std;
+
+//Bytes scanned per block, one bit per byte in the masks
+const size_t TOKENIZER_BLOCK = 64;
+
+// Masks of the bytes equal to delimiter and to '\n' among the 64 bytes at p
+void scan_block(const char* p, char delimiter, unsigned long long& delimiters, unsigned long long& newlines) {
+
+#if defined(__AVX2__)
+	const __m256i d = _mm256_set1_epi8(delimiter);
+	const __m256i nl = _mm256_set1_epi8('\n');
+
+	__m256i lo = _mm256_loadu_si256((const __m256i*) p);
+	__m256i hi = _mm256_loadu_si256((const __m256i*) (p + 32));
+
+	delimiters = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, d))
+		| ((unsigned long long) (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, d)) << 32);
+	newlines = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, nl))
+		| ((unsigned long long) (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, nl)) << 32);
+#elif defined(__SSE2__)
+	const __m128i d = _mm_set1_epi8(delimiter);
+	const __m128i nl = _mm_set1_epi8('\n');
+
+	delimiters = 0;
+	newlines = 0;
+
+	for (int i = 0; i < 4; i++) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (p + 16 * i));
+		delimiters |= (unsigned long long) (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(v, d)) << (16 * i);
+		newlines |= (unsigned long long) (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)) << (16 * i);
+	}
+#else
+	delimiters = 0;
+	newlines = 0;
+
+	for (size_t i = 0; i < TOKENIZER_BLOCK; i++) {
+		delimiters |= (unsigned long long) (p[i] == delimiter) << i;
+		newlines |= (unsigned long long) (p[i] == '\n') << i;
+	}
+#endif
+}
+
+// Same as scan_block over the n < 64 bytes left at the end of a buffer, never reading past them
+void scan_tail(const char* p, size_t n, char delimiter, unsigned long long& delimiters, unsigned long long& newlines) {
+
+	delimiters = 0;
+	newlines = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		delimiters |= (unsigned long long) (p[i] == delimiter) << i;
+		newlines |= (unsigned long long) (p[i] == '\n') << i;
+	}
+}
+
+// Position of the lowest set bit, bits must be non-zero
+int lowest_bit(unsigned long long bits) {
+#if defined(__GNUC__)
+	return __builtin_ctzll(bits);
+#else
+	int i = 0;
+	while (!(bits & 1)) {
+		bits >>= 1;
+		i++;
+	}
+	return i;
+#endif
+}
+
+/**
+ * Walks a buffer line by line, handing out the fields of each line as StringViews into the
+ * buffer. Delimiter positions come from the block masks, so a field costs one bit scan rather
+ * than a character loop or a memchr call. A trailing \r is dropped from the last field, and a
+ * final line without a newline is still returned.
+ */
+class Tokenizer
+{
+private:
+
+	const char* pos;
+	const char* end;
+	char delimiter;
+
+	//Current block and the delimiter/newline bits not yet consumed from it
+	const char* block;
+	const char* block_end;
+	unsigned long long bits;
+	unsigned long long newline_bits;
+
+	// Scan the block following the current one
+	void LoadBlock();
+
+public:
+
+	Tokenizer(const char* data, size_t size, char delimiter_ = ',');
+
+	Tokenizer(const MappedFile& file, char delimiter_ = ',');
+
+	// Fields of the next line into fields, false once the buffer is exhausted
+	bool NextLine(vector<StringView>& fields);
+
+	// Start of the next line, the end of the buffer once it is exhausted
+	const char* Position() const;
+
+};
+
+Tokenizer::Tokenizer(const char* data, size_t size, char delimiter_) {
+	pos = data;
+	end = data + size;
+	delimiter = delimiter_;
+	block = data;
+	block_end = data;
+	bits = 0;
+	newline_bits = 0;
+}
+
+Tokenizer::Tokenizer(const MappedFile& file, char delimiter_) {
+	pos = file.data();
+	end = file.data() + file.size();
+	delimiter = delimiter_;
+	block = pos;
+	block_end = pos;
+	bits = 0;
+	newline_bits = 0;
+}
+
+void Tokenizer::LoadBlock() {
+
+	block = block_end;
+
+	unsigned long long delimiters;
+
+	if ((size_t) (end - block) >= TOKENIZER_BLOCK) {
+		scan_block(block, delimiter, delimiters, newline_bits);
+		block_end = block + TOKENIZER_BLOCK;
+	}
+	else {
+		scan_tail(block, end - block, delimiter, delimiters, newline_bits);
+		block_end = end;
+	}
+
+	bits = delimiters | newline_bits;
+}
+
+bool Tokenizer::NextLine(vector<StringView>& fields) {
+
+	fields.clear();
+
+	if (pos == NULL || pos >= end) {
+		return false;
+	}
+
+	const char* field_start = pos;
+
+	while (true) {
+
+		if (bits == 0) {
+
+			//No delimiters left anywhere, the rest of the buffer is the last field
+			if (block_end >= end) {
+				size_t len = end - field_start;
+				if (len > 0 && field_start[len - 1] == '\r') {
+					len--;
+				}
+				fields.push_back(StringView(field_start, len));
+				pos = end;
+				return true;
+			}
+
+			LoadBlock();
+			continue;
+		}
+
+		int i = lowest_bit(bits);
+		bits &= bits - 1;
+
+		const char* d = block + i;
+
+		if ((newline_bits >> i) & 1) {
+			size_t len = d - field_start;
+			if (len > 0 && field_start[len - 1] == '\r') {
+				len--;
+			}
+			fields.push_back(StringView(field_start, len));
+			pos = d + 1;
+			return true;
+		}
+
+		fields.push_back(StringView(field_start, d - field_start));
+		field_start = d + 1;
+	}
+}
+
+const char* Tokenizer::Position() const {
+	return pos;
+}
+
+#endif
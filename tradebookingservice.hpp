@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 #include "soa.hpp"
+#include "tickprice.hpp"
 
 // Trade sides
 enum Side { BUY, SELL };
@@ -25,16 +26,19 @@ class Trade
 public:
 
   // ctor for a trade
-  Trade(const T &_product, string _tradeId, double _price, string _book, long _quantity, Side _side);
+  Trade(const T &_product, string _tradeId, TickPrice _price, string _book, long _quantity, Side _side);
 
   // Get the product
   const T& GetProduct() const;
 
+  // Get the dense index of the product
+  int GetProductIndex() const;
+
   // Get the trade ID
   const string& GetTradeId() const;
 
   // Get the mid price
-  double GetPrice() const;
+  TickPrice GetPrice() const;
 
   // Get the book
   const string& GetBook() const;
@@ -46,9 +50,10 @@ public:
   Side GetSide() const;
 
 private:
-  T product;
+  const T* product;
+  int productIndex;
   string tradeId;
-  double price;
+  TickPrice price;
   string book;
   long quantity;
   Side side;
@@ -72,9 +77,10 @@ public:
 };
 
 template<typename T>
-Trade<T>::Trade(const T &_product, string _tradeId, double _price, string _book, long _quantity, Side _side) :
-  product(_product)
+Trade<T>::Trade(const T &_product, string _tradeId, TickPrice _price, string _book, long _quantity, Side _side) :
+  product(&_product)
 {
+  productIndex = _product.GetProductIndex();
   tradeId = _tradeId;
   price = _price;
   book = _book;
@@ -85,7 +91,13 @@ Trade<T>::Trade(const T &_product, string _tradeId, double _price, string _book,
 template<typename T>
 const T& Trade<T>::GetProduct() const
 {
-  return product;
+  return *product;
+}
+
+template<typename T>
+int Trade<T>::GetProductIndex() const
+{
+  return productIndex;
 }
 
 template<typename T>
@@ -95,7 +107,7 @@ const string& Trade<T>::GetTradeId() const
 }
 
 template<typename T>
-double Trade<T>::GetPrice() const
+TickPrice Trade<T>::GetPrice() const
 {
   return price;
 }
@@ -7,6 +7,54 @@
 #define TREASURY_PRICES_HPP
 
 #include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <ostream>
+#include "stringview.hpp"
+
+//Treasury prices trade in 1/256ths: 32nds of a point, each split into eighths
+const int TICKS_PER_POINT = 256;
+
+// Price in integer-xyz notation as a count of 1/256 ticks, z may be + for 4.
+// Reads the characters in place, so there is no allocation and no sscanf.
+int parse_ticks(const char* p, size_t n) {
+
+	size_t i = 0;
+	int integer = 0;
+
+	while (i < n && p[i] != '-') {
+		integer = integer * 10 + (p[i] - '0');
+		i++;
+	}
+
+	//Common case: delimiter followed by xy and z
+	if (i + 3 < n) {
+		const char* f = p + i + 1;
+		int z = f[2] == '+' ? 4 : f[2] - '0';
+		return integer * TICKS_PER_POINT + ((f[0] - '0') * 10 + (f[1] - '0')) * 8 + z;
+	}
+
+	//Truncated input, take whatever digits are there
+	int xy = 0;
+	for (i++; i < n; i++) {
+		xy = xy * 10 + (p[i] - '0');
+	}
+
+	return integer * TICKS_PER_POINT + xy * 8;
+}
+
+int parse_ticks(StringView s) {
+	return parse_ticks(s.data(), s.size());
+}
+
+// Parse count prices taken every stride fields from fields, e.g. stride 3 over the
+// price,quantity,side triples of a marketdata.txt line
+void parse_ticks_batch(const StringView* fields, size_t count, size_t stride, int* ticks) {
+	for (size_t i = 0; i < count; i++) {
+		ticks[i] = parse_ticks(fields[i * stride]);
+	}
+}
 
 //Class to handle treasury price notation
 class TreasuryPrices {
@@ -22,8 +70,13 @@ public:
 
 	TreasuryPrices(const std::string&);
 
+	TreasuryPrices(StringView);
+
 	TreasuryPrices(int, int, int);
 
+	// Price from a count of 1/256 ticks
+	static TreasuryPrices fromTicks(int);
+
 	TreasuryPrices operator* (const int);
 
 	TreasuryPrices operator+ (const TreasuryPrices&);
@@ -47,6 +100,9 @@ public:
 	//Convert to decimal notation
 	double toDouble();
 
+	//Convert to a count of 1/256 ticks
+	int toTicks() const;
+
 	//Used for midpoint increment - differs from * -1 since we don't call standardize
 	void negate();
 
@@ -65,13 +121,11 @@ TreasuryPrices::TreasuryPrices() {
 }
 
 TreasuryPrices::TreasuryPrices(const std::string& s) {
+	*this = fromTicks(parse_ticks(s.data(), s.size()));
+}
 
-	std::string::size_type delim_position = s.find("-");
-
-	//Pre-c++11
-	std::sscanf(s.substr(0, delim_position).c_str(),"%d", &integer);
-	std::sscanf(s.substr(delim_position + 1, 2).c_str(),"%d", &xy);
-	std::sscanf(s.substr(delim_position + 3, 1).c_str(),"%d", &z);
+TreasuryPrices::TreasuryPrices(StringView s) {
+	*this = fromTicks(parse_ticks(s));
 }
 
 TreasuryPrices::TreasuryPrices(int i_, int xy_, int z_) {
@@ -80,6 +134,12 @@ TreasuryPrices::TreasuryPrices(int i_, int xy_, int z_) {
 	z = z_;
 }
 
+TreasuryPrices TreasuryPrices::fromTicks(int ticks) {
+	int new_integer = ticks / TICKS_PER_POINT;
+	int remainder = ticks - new_integer * TICKS_PER_POINT;
+	return TreasuryPrices(new_integer, remainder / 8, remainder % 8);
+}
+
 TreasuryPrices TreasuryPrices::standardize(TreasuryPrices t) {
 
 	int remainder = t.getInteger() * 256 + t.getXY() * 8 + t.getZ();
@@ -126,6 +186,10 @@ double TreasuryPrices::toDouble() {
 	return integer + xy / 32.0 + z / 256.0;
 }
 
+int TreasuryPrices::toTicks() const {
+	return integer * TICKS_PER_POINT + xy * 8 + z;
+}
+
 void TreasuryPrices::negate() {
 	integer *= -1;
 	xy *= -1;
@@ -144,25 +208,108 @@ int TreasuryPrices::getZ() const {
 	return z;
 }
 
-//Output treasury price as integer-xyz
-std::ostream& operator<< (std::ostream& os, const TreasuryPrices& t) {
+// Write n in decimal to out, returns the number of characters written
+size_t format_int(int n, char* out) {
+
+	char digits[12];
+	size_t len = 0;
+
+	unsigned int u = n < 0 ? 0u - (unsigned int) n : (unsigned int) n;
+	do {
+		digits[len++] = (char) ('0' + u % 10);
+		u /= 10;
+	} while (u > 0);
 
-	os << t.getInteger() << "-";
+	size_t i = 0;
+	if (n < 0) {
+		out[i++] = '-';
+	}
+	while (len > 0) {
+		out[i++] = digits[--len];
+	}
+
+	return i;
+}
 
-	if (t.getXY() < 10) {
-		os << "0";
+// Render integer-xyz the way operator<< always has, z of 4 as +, into out (at least 40 chars).
+// Returns the number of characters written.
+size_t format_price(int integer, int xy, int z, char* out) {
+
+	size_t i = format_int(integer, out);
+	out[i++] = '-';
+
+	if (xy < 10) {
+		out[i++] = '0';
 	}
-		
-	os << t.getXY();
+	i += format_int(xy, out + i);
 
-	if (t.getZ() == 4) {
-		os << "+";
+	if (z == 4) {
+		out[i++] = '+';
 	}
 	else {
-		os << t.getZ();
+		i += format_int(z, out + i);
 	}
 
-	return os;
+	return i;
+}
+
+//Tick range with pre-rendered strings, 99-000 to 101-000 which covers all generated data
+const int PRICE_TABLE_MIN_TICKS = 99 * TICKS_PER_POINT;
+const int PRICE_TABLE_MAX_TICKS = 101 * TICKS_PER_POINT;
+
+//Rendered text of one tick count, "100-31+" is the longest in the table
+struct RenderedPrice
+{
+	char text[8];
+	unsigned char len;
+};
+
+// Table of rendered prices indexed by ticks - PRICE_TABLE_MIN_TICKS, built on first use
+const std::vector<RenderedPrice>& price_table() {
+
+	static const std::vector<RenderedPrice> table = [] {
+
+		std::vector<RenderedPrice> rendered(PRICE_TABLE_MAX_TICKS - PRICE_TABLE_MIN_TICKS + 1);
+		char buffer[40];
+
+		for (int t = PRICE_TABLE_MIN_TICKS; t <= PRICE_TABLE_MAX_TICKS; t++) {
+			RenderedPrice& r = rendered[t - PRICE_TABLE_MIN_TICKS];
+			r.len = (unsigned char) format_price(t / TICKS_PER_POINT, (t % TICKS_PER_POINT) / 8, t % 8, buffer);
+			memcpy(r.text, buffer, r.len);
+		}
+
+		return rendered;
+	}();
+
+	return table;
+}
+
+// Render a price into out (at least 40 chars), returns the number of characters written.
+// Standard prices in the table range are a copy out of price_table, anything else is
+// formatted digit by digit.
+size_t format_price(const TreasuryPrices& t, char* out) {
+
+	int integer = t.getInteger(), xy = t.getXY(), z = t.getZ();
+
+	if (integer >= 0 && xy >= 0 && xy < 32 && z >= 0 && z < 8) {
+
+		int ticks = integer * TICKS_PER_POINT + xy * 8 + z;
+
+		if (ticks >= PRICE_TABLE_MIN_TICKS && ticks <= PRICE_TABLE_MAX_TICKS) {
+			const RenderedPrice& r = price_table()[ticks - PRICE_TABLE_MIN_TICKS];
+			memcpy(out, r.text, sizeof(r.text));
+			return r.len;
+		}
+	}
+
+	return format_price(integer, xy, z, out);
+}
+
+//Output treasury price as integer-xyz
+std::ostream& operator<< (std::ostream& os, const TreasuryPrices& t) {
+
+	char buffer[40];
+	return os.write(buffer, format_price(t, buffer));
 }
 
 #endif
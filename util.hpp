@@ -6,6 +6,7 @@
 
 #include <vector>
 #include <string>
+#include "stringview.hpp"
 
 using namespace std;
 
@@ -24,4 +25,55 @@ vector<string> split(string s, string delimiter) {
 	return res;
 }
 
+// Parse a run of decimal digits, with an optional leading minus sign
+long parse_long(StringView s) {
+
+	size_t i = 0;
+	bool negative = s.size() > 0 && s[0] == '-';
+	if (negative) {
+		i++;
+	}
+
+	long value = 0;
+	for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; i++) {
+		value = value * 10 + (s[i] - '0');
+	}
+
+	return negative ? -value : value;
+}
+
+// Parse a decimal number of digits with an optional fraction, like 4.125, with an optional
+// leading minus sign
+double parse_double(StringView s) {
+
+	size_t i = 0;
+	bool negative = s.size() > 0 && s[0] == '-';
+	if (negative) {
+		i++;
+	}
+
+	//Digits accumulate as an integer and are scaled once, exact for values as short as coupons
+	long long digits = 0;
+	double scale = 1;
+	bool fraction = false;
+
+	for (; i < s.size(); i++) {
+		if (s[i] >= '0' && s[i] <= '9') {
+			digits = digits * 10 + (s[i] - '0');
+			if (fraction) {
+				scale *= 10;
+			}
+		}
+		else if (s[i] == '.' && !fraction) {
+			fraction = true;
+		}
+		else {
+			break;
+		}
+	}
+
+	double value = digits / scale;
+	return negative ? -value : value;
+}
+
 #endif
\ No newline at end of file